@@ -1,9 +1,21 @@
 #include <utility>
+#include <algorithm>
 #include <random>
 #include <vector>
+#include <map>
 #include <string>
 #include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
 #include <iostream>
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#endif
 #include "src/main.hxx"
 
 using namespace std;
@@ -11,6 +23,291 @@ using namespace std;
 
 
 
+// OPTIONS
+// -------
+// Experiment setup, from command line (--key value) or a config file (key value).
+
+struct Options {
+  vector<string> files;
+  vector<int>    batchSizes = {500, 1000, 5000, 10000, 50000, 100000};
+  int            batchCount = 5;
+  int            sequenceLength = 0;   // chain batches on one evolving graph (0: independent batches)
+  int            driftInterval  = 10;  // run static Louvain every so many chained batches
+  int            coalesceSize     = 0;  // stream: run once so many updates are buffered (0: no limit)
+  double         coalesceAffected = 0;  // stream: run once updates touch this fraction of vertices (0: no limit)
+  double         latencyBudget    = 0;  // stream: run once oldest update has waited so long, in ms (0: no limit)
+  bool           pipeline   = false;  // stage next chained batch while dynamic Louvain runs on current one
+  bool           many       = false;  // run static Louvain on all graphs together, one task per graph
+  vector<double> insertionFractions = {1, 0};  // 1: insertions only, 0: deletions only
+  double         reweightFraction   = 0;       // fraction of batch changing weight of existing edges
+  string         workload   = "uniform";  // uniform, degree, community
+  vector<string> techniques = {"louvainSeqStatic", "louvainSeqNaiveDynamic", "louvainSeqDynamicDeltaScreening", "louvainSeqDynamicFrontier", "louvainSeqDynamicDeltaFrontier"};
+  vector<int>    threads    = {1};  // sweep, with speedup relative to the first
+  string         schedule   = "dynamic";  // static, dynamic, guided, auto (of parallel loops)
+  int            chunkSize  = 2048;       // 0: default of schedule
+  string         numa       = "none";     // none, first-touch, interleave (of parallel Louvain buffers)
+  bool           balance    = false;      // degree-balanced chunks of vertices (parallel Louvain)
+  size_t         hubDegree  = 0;          // scan vertices with this degree using all threads (0: none)
+  string         conflict   = "none";     // none, singleton, color (conflict mitigation of parallel Louvain)
+  string         affected   = "dense";    // dense, sparse, hybrid (affected vertex set of dynamic Louvain)
+  vector<double> autoLimits = {0.2, 0.4, 0.8};  // estimated affected fraction upto which auto picks frontier, delta-screening, naive-dynamic
+  double         timeBudget = 0;  // stop each run of Louvain after so long, in ms (0: none)
+  int            repeat     = 5;
+  int            warmup     = 1;
+  bool           pin        = false;   // pin threads to cpus
+  string         format     = "text";  // text, jsonl, csv
+};
+
+
+vector<string> splitValues(const string& x) {
+  vector<string> a; string v;
+  stringstream s(x);
+  while (getline(s, v, ','))
+    if (!v.empty()) a.push_back(v);
+  return a;
+}
+
+vector<int> splitIntegers(const string& x) {
+  vector<int> a;
+  for (const auto& v : splitValues(x))
+    a.push_back(stoi(v));
+  return a;
+}
+
+vector<double> splitDoubles(const string& x) {
+  vector<double> a;
+  for (const auto& v : splitValues(x))
+    a.push_back(stod(v));
+  return a;
+}
+
+
+string techniqueName(const string& x) {
+  if (x=="static")          return "louvainSeqStatic";
+  if (x=="naive-dynamic")   return "louvainSeqNaiveDynamic";
+  if (x=="delta-screening") return "louvainSeqDynamicDeltaScreening";
+  if (x=="frontier")        return "louvainSeqDynamicFrontier";
+  if (x=="delta-frontier")  return "louvainSeqDynamicDeltaFrontier";
+  if (x=="auto")            return "louvainSeqDynamicAuto";
+  if (x=="static-omp")          return "louvainOmpStatic";
+  if (x=="naive-dynamic-omp")   return "louvainOmpNaiveDynamic";
+  if (x=="delta-screening-omp") return "louvainOmpDynamicDeltaScreening";
+  if (x=="frontier-omp")        return "louvainOmpDynamicFrontier";
+  if (x=="delta-frontier-omp")  return "louvainOmpDynamicDeltaFrontier";
+  if (x=="auto-omp")            return "louvainOmpDynamicAuto";
+  return x;
+}
+
+bool isStaticTechnique(const string& x) {
+  return x=="louvainSeqStatic" || x=="louvainOmpStatic";
+}
+
+// Does technique continue from an aggregated graph of previous communities?
+bool hasAggregate(const string& x) {
+  return x.find("DeltaScreening")!=string::npos || x.find("Frontier")!=string::npos || x.find("Auto")!=string::npos;
+}
+
+
+void printUsage(const char *prog) {
+  fprintf(stderr, "usage: %s [--config <file>] [--batch-sizes 500,1000,...] [--batch-count 5] [--insertion-fractions 1,0.5,0] [--reweight-fraction 0] [--sequence-length 0] [--drift-interval 10] [--coalesce-size 0] [--coalesce-affected 0] [--latency-budget 0] [--pipeline 0|1] [--many 0|1] [--workload uniform|degree|community] [--techniques static,naive-dynamic,delta-screening,frontier,delta-frontier,static-omp,...] [--threads 1,2,...] [--schedule dynamic[,2048]] [--numa none|first-touch|interleave] [--balance 0|1] [--hub-degree 0] [--conflict none|singleton|color] [--affected dense|sparse|hybrid] [--auto-limits 0.2,0.4,0.8] [--time-budget 0] [--repeat 5] [--warmup 1] [--pin 0|1] [--format text|jsonl|csv] <graph.mtx>...\n", prog);
+}
+
+
+void readConfig(Options& o, const char *pth);
+
+bool setOption(Options& o, const string& k, const string& v) {
+  if      (k=="graph")       o.files.push_back(v);
+  else if (k=="config")      readConfig(o, v.c_str());
+  else if (k=="batch-sizes") o.batchSizes = splitIntegers(v);
+  else if (k=="batch-count") o.batchCount = stoi(v);
+  else if (k=="sequence-length")     o.sequenceLength     = stoi(v);
+  else if (k=="drift-interval")      o.driftInterval      = stoi(v);
+  else if (k=="coalesce-size")       o.coalesceSize       = stoi(v);
+  else if (k=="coalesce-affected")   o.coalesceAffected   = stod(v);
+  else if (k=="latency-budget")      o.latencyBudget      = stod(v);
+  else if (k=="pipeline")    o.pipeline   = v=="1" || v=="true";
+  else if (k=="many")        o.many       = v=="1" || v=="true";
+  else if (k=="insertion-fractions") o.insertionFractions = splitDoubles(v);
+  else if (k=="reweight-fraction")   o.reweightFraction   = stod(v);
+  else if (k=="workload")    o.workload   = v;
+  else if (k=="threads")     o.threads    = splitIntegers(v);
+  else if (k=="schedule") {
+    auto vs = splitValues(v);
+    o.schedule  = vs.empty()? "dynamic" : vs[0];
+    o.chunkSize = vs.size()>1? stoi(vs[1]) : 0;
+  }
+  else if (k=="repeat")      o.repeat     = stoi(v);
+  else if (k=="warmup")      o.warmup     = stoi(v);
+  else if (k=="numa")        o.numa       = v;
+  else if (k=="balance")     o.balance    = v=="1" || v=="true";
+  else if (k=="hub-degree")  o.hubDegree  = stoul(v);
+  else if (k=="conflict")    o.conflict   = v;
+  else if (k=="affected")    o.affected   = v;
+  else if (k=="auto-limits") o.autoLimits = splitDoubles(v);
+  else if (k=="time-budget") o.timeBudget = stod(v);
+  else if (k=="pin")         o.pin        = v=="1" || v=="true";
+  else if (k=="format")      o.format     = v;
+  else if (k=="techniques") {
+    o.techniques.clear();
+    for (const auto& t : splitValues(v))
+      o.techniques.push_back(techniqueName(t));
+  }
+  else return false;
+  return true;
+}
+
+
+void readConfig(Options& o, const char *pth) {
+  ifstream f(pth);
+  if (!f) { fprintf(stderr, "error: cannot open config file \"%s\"\n", pth); exit(1); }
+  string ln;
+  while (getline(f, ln)) {
+    ln = ln.substr(0, ln.find('#'));
+    replace(ln.begin(), ln.end(), '=', ' ');
+    stringstream s(ln); string k, v;
+    if (!(s >> k)) continue;
+    s >> v;
+    // Malformed numbers are reported here, and passed on for the usage line.
+    try { if (!setOption(o, k, v)) { fprintf(stderr, "error: unknown option \"%s\" in %s\n", k.c_str(), pth); exit(1); } }
+    catch (const logic_error&) { fprintf(stderr, "error: invalid value \"%s\" for option \"%s\" in %s\n", v.c_str(), k.c_str(), pth); throw; }
+  }
+}
+
+
+Options readOptions(int argc, char **argv) {
+  Options o; int positional = 0;
+  for (int i=1; i<argc; ++i) {
+    string a = argv[i];
+    if (a.rfind("--", 0)==0) {
+      size_t e = a.find('=');
+      string k = a.substr(2, e==string::npos? string::npos : e-2);
+      string v = e!=string::npos? a.substr(e+1) : i+1<argc? argv[++i] : "";
+      // Missing or malformed numbers (stoi(), stod()) show the usage line.
+      bool known = false;
+      try { known = setOption(o, k, v); }
+      catch (const logic_error&) {
+        if (k!="config") fprintf(stderr, "error: invalid value \"%s\" for option \"--%s\"\n", v.c_str(), k.c_str());
+        printUsage(argv[0]);
+        exit(1);
+      }
+      if (!known) { fprintf(stderr, "error: unknown option \"%s\"\n", a.c_str()); exit(1); }
+    }
+    // Legacy usage: <graph> [repeat]
+    else if (positional++==1 && o.files.size()==1 && isdigit(a[0])) {
+      try { o.repeat = stoi(a); }
+      catch (const logic_error&) { fprintf(stderr, "error: invalid repeat \"%s\"\n", a.c_str()); printUsage(argv[0]); exit(1); }
+    }
+    else o.files.push_back(a);
+  }
+  // Limits not given keep their defaults, and all must be non-decreasing.
+  LouvainAutoLimits ld;
+  double l[3] = {ld.frontier, ld.deltaScreening, ld.naiveDynamic};
+  if (o.autoLimits.size()>3) { fprintf(stderr, "error: --auto-limits takes at most 3 values\n"); exit(1); }
+  for (size_t i=0; i<o.autoLimits.size(); ++i) l[i] = o.autoLimits[i];
+  if (!(0<=l[0] && l[0]<=l[1] && l[1]<=l[2])) { fprintf(stderr, "error: --auto-limits %g,%g,%g must be non-negative and non-decreasing\n", l[0], l[1], l[2]); exit(1); }
+  // Coloring schedules vertices by color, in place of chunks and sparse affected vertices.
+  if (o.conflict=="color" && o.balance) { fprintf(stderr, "error: --conflict color cannot be used with --balance\n"); exit(1); }
+  if (o.conflict=="color" && o.affected!="dense") { fprintf(stderr, "error: --conflict color cannot be used with --affected %s\n", o.affected.c_str()); exit(1); }
+  return o;
+}
+
+
+
+
+// RESULT
+// ------
+// Write results in text (for logs), JSON Lines, or CSV format.
+
+struct Record {
+  string graph;
+  size_t order = 0;
+  size_t size  = 0;
+  double batchSize  = 0;
+  int    batchIndex = 0;
+  double insertionFraction = 1;
+  size_t insertions = 0;  // edges inserted (both directions)
+  size_t deletions  = 0;  // edges deleted (both directions)
+  size_t reweights  = 0;  // edges with changed weight (both directions)
+  double staticModularity = NAN;  // of static Louvain on the same graph, if run
+  int    threads    = 1;
+  size_t peakResident = 0;  // peak RSS of the process while the result was computed (bytes)
+};
+
+
+// Speedup of each phase over the same technique with the first thread count,
+// and parallel efficiency (speedup per unit of added threads).
+struct Scaling {
+  int    baseThreads = 0;  // 0: no thread sweep
+  double speedup[6]    = {};  // total, init, mark, move, aggr, look
+  double efficiency[6] = {};
+};
+
+template <class K>
+Scaling scaling(const LouvainResult<K>& a, const LouvainResult<K>& b, int threads, int baseThreads) {
+  Scaling s;
+  double ta[6] = {a.time, a.initializationTime, a.markingTime, a.localMoveTime, a.aggregationTime, a.lookupTime};
+  double tb[6] = {b.time, b.initializationTime, b.markingTime, b.localMoveTime, b.aggregationTime, b.lookupTime};
+  s.baseThreads = baseThreads;
+  for (int i=0; i<6; ++i) {
+    s.speedup[i]    = ta[i]>0? tb[i]/ta[i] : NAN;
+    s.efficiency[i] = s.speedup[i] * baseThreads / threads;
+  }
+  return s;
+}
+
+
+// Pin the calling thread to a cpu, so that it does not migrate between runs.
+void pinThread(int i) {
+  #ifdef __linux__
+  long N = sysconf(_SC_NPROCESSORS_ONLN);
+  cpu_set_t s;
+  CPU_ZERO(&s);
+  CPU_SET(int(i % max(N, 1L)), &s);
+  sched_setaffinity(0, sizeof(s), &s);
+  #endif
+}
+
+
+omp_sched_t scheduleKind(const string& x) {
+  if (x=="static") return omp_sched_static;
+  if (x=="guided") return omp_sched_guided;
+  if (x=="auto")   return omp_sched_auto;
+  return omp_sched_dynamic;
+}
+
+
+void setThreads(int t, bool pin=false, const string& schedule="dynamic", int chunkSize=0) {
+  #ifdef _OPENMP
+  omp_set_num_threads(t);
+  omp_set_schedule(scheduleKind(schedule), chunkSize);
+  if (pin) {
+    #pragma omp parallel
+    pinThread(omp_get_thread_num());
+  }
+  #else
+  if (pin) pinThread(0);
+  #endif
+}
+
+
+template <class V>
+LouvainOptions<V> louvainOptions(const Options& o) {
+  LouvainOptions<V> a(o.repeat);
+  a.warmup = o.warmup;
+  a.numa   = o.numa=="first-touch"? NUMA_FIRST_TOUCH : o.numa=="interleave"? NUMA_INTERLEAVE : NUMA_DEFAULT;
+  a.balance   = o.balance;
+  a.hubDegree = o.hubDegree;
+  a.conflict  = o.conflict=="singleton"? LOUVAIN_CONFLICT_SINGLETON : o.conflict=="color"? LOUVAIN_CONFLICT_COLOR : LOUVAIN_CONFLICT_NONE;
+  a.affected  = o.affected=="sparse"? AFFECTED_SPARSE : o.affected=="hybrid"? AFFECTED_HYBRID : AFFECTED_DENSE;
+  auto& l = o.autoLimits;
+  if (l.size()>0) a.autoLimits.frontier       = l[0];
+  if (l.size()>1) a.autoLimits.deltaScreening = l[1];
+  if (l.size()>2) a.autoLimits.naiveDynamic   = l[2];
+  a.timeBudget = float(o.timeBudget);
+  return a;
+}
+
+
 template <class G, class K, class V>
 double getModularity(const G& x, const LouvainResult<K>& a, V M) {
   auto fc = [&](auto u) { return a.membership[u]; };
@@ -18,113 +315,558 @@ double getModularity(const G& x, const LouvainResult<K>& a, V M) {
 }
 
 
-template <class G, class R, class K, class V>
-auto addRandomEdges(G& a, R& rnd, K span, V w, int batchSize) {
+void printPerfCounts(const PerfCounts& c, size_t pass, const char *phase) {
+  double ipc = c.cycles? double(c.instructions)/c.cycles : 0;
+  printf("- pass %zu %s: %.3e cycles; %.3e instructions; %.3f IPC; %.3e LLC misses; %.3e branch misses\n", pass+1, phase, double(c.cycles), double(c.instructions), ipc, double(c.cacheMisses), double(c.branchMisses));
+}
+
+
+// Mean busy time of threads, and how much longer the busiest thread is busy.
+double busyMean(const vector<float>& x) {
+  return x.empty()? 0 : sumValues(x, 0.0) / x.size();
+}
+
+double busyImbalance(const vector<float>& x) {
+  double m = busyMean(x);
+  return m>0? *max_element(x.begin(), x.end()) / m : NAN;
+}
+
+
+template <class K>
+void printResult(const Options& o, const Record& r, const LouvainResult<K>& a, double modularity, const char *technique, const Scaling& s) {
+  printf("[%1.0e batch_size; %09.3f ms; %04d iters.; %03d passes; %01.9f modularity] %s", r.batchSize, a.time, a.iterations, a.passes, modularity, technique);
+  printf(" {threads: %d; schedule: %s,%d; numa: %s; balance: %d; hub_degree: %zu; conflict: %s; affected: %s}", r.threads, o.schedule.c_str(), o.chunkSize, o.numa.c_str(), o.balance, o.hubDegree, o.conflict.c_str(), o.affected.c_str());
+  printf(" {batch: %zu insertions; %zu deletions; %zu reweights}", r.insertions, r.deletions, r.reweights);
+  if (!isnan(r.staticModularity)) printf(" {drift: %+.9f modularity}", modularity - r.staticModularity);
+  if (!isnan(a.estimatedAffected)) printf(" {auto: %s; estimated_affected: %.3e}", a.technique>=0? louvainTechniqueName(a.technique) : "-", a.estimatedAffected);
+  if (a.truncated) printf(" {truncated}");
+  printf(" {memory: %zu graph; %zu aggregate; %zu workspace; %zu affected; %zu peak_rss bytes}", a.graphBytes, a.aggregateBytes, a.workspaceBytes, a.affectedBytes, r.peakResident);
+  printf(" {min: %09.3f ms; median: %09.3f ms; stddev: %09.3f ms}", a.minTime, a.medianTime, a.stddevTime);
+  printf(" {init: %07.3f ms; mark: %07.3f ms; move: %07.3f ms; aggr: %07.3f ms; look: %07.3f ms}", a.initializationTime, a.markingTime, a.localMoveTime, a.aggregationTime, a.lookupTime);
+  for (size_t i=0; i<a.passTime.size(); ++i)
+    printf(" {pass: %07.3f ms; %04d iters.; %d vertices}", a.passTime[i], a.passIterations[i], int(a.passVertices[i]));
+  if (!a.threadBusyTime.empty()) {
+    const auto& b = a.threadBusyTime;
+    printf(" {busy: %07.3f ms min; %07.3f ms mean; %07.3f ms max; %.3f imbalance}", *min_element(b.begin(), b.end()), busyMean(b), *max_element(b.begin(), b.end()), busyImbalance(b));
+  }
+  if (s.baseThreads) {
+    const double *x = s.speedup, *y = s.efficiency;
+    printf(" {speedup: %.3fx; init: %.3fx; mark: %.3fx; move: %.3fx; aggr: %.3fx; look: %.3fx; vs %d threads}", x[0], x[1], x[2], x[3], x[4], x[5], s.baseThreads);
+    printf(" {efficiency: %.3f; init: %.3f; mark: %.3f; move: %.3f; aggr: %.3f; look: %.3f}", y[0], y[1], y[2], y[3], y[4], y[5]);
+  }
+  printf("\n");
+  for (size_t i=0; i<a.passLocalMoveCounts.size(); ++i) {
+    if (i<a.passInitializationCounts.size()) printPerfCounts(a.passInitializationCounts[i], i, "init");
+    printPerfCounts(a.passLocalMoveCounts[i], i, "move");
+    if (i<a.passAggregationCounts.size()) printPerfCounts(a.passAggregationCounts[i], i, "aggr");
+    if (i<a.passLookupCounts.size())      printPerfCounts(a.passLookupCounts[i], i, "look");
+  }
+}
+
+
+template <class T>
+void writeJsonValues(FILE *a, const vector<T>& x) {
+  fprintf(a, "[");
+  for (size_t i=0; i<x.size(); ++i)
+    fprintf(a, i? ",%g" : "%g", double(x[i]));
+  fprintf(a, "]");
+}
+
+template <class T>
+void writeCsvValues(FILE *a, const vector<T>& x) {
+  for (size_t i=0; i<x.size(); ++i)
+    fprintf(a, i? ";%g" : "%g", double(x[i]));
+}
+
+
+// Write a number, or nothing (csv)/null (json) if it is not.
+void writeNumber(FILE *a, double x, bool json) {
+  if (!isnan(x)) fprintf(a, "%g", x);
+  else if (json) fprintf(a, "null");
+}
+
+
+// Write counts of a phase summed over passes, or nothing (csv)/null (json) if not recorded.
+void writePerfCounts(FILE *a, const vector<PerfCounts>& x, const char *phase, bool json) {
+  static const char *counters[4] = {"cycles", "instructions", "llc_misses", "branch_misses"};
+  PerfCounts c;
+  for (const auto& y : x) c += y;
+  double v[4] = {double(c.cycles), double(c.instructions), double(c.cacheMisses), double(c.branchMisses)};
+  for (int i=0; i<4; ++i) {
+    if (json) fprintf(a, "\"%s%s\":", phase, counters[i]);
+    else if (i) fprintf(a, ",");
+    writeNumber(a, x.empty()? NAN : v[i], json);
+    if (json) fprintf(a, ",");
+  }
+}
+
+
+template <class K>
+void writeResult(const Options& o, const Record& r, const LouvainResult<K>& a, double modularity, const char *technique, const Scaling& s={}) {
+  static const char *phases[6] = {"", "initialization_", "marking_", "local_move_", "aggregation_", "lookup_"};
+  static bool header = false;
+  if (o.format=="jsonl") {
+    printf("{\"graph\":\"%s\",\"order\":%zu,\"size\":%zu,\"batch_size\":%g,\"batch_index\":%d,\"insertion_fraction\":%g,\"insertions\":%zu,\"deletions\":%zu,\"reweights\":%zu,\"workload\":\"%s\",\"threads\":%d,\"schedule\":\"%s\",\"chunk_size\":%d,\"numa\":\"%s\",\"balance\":%d,\"hub_degree\":%zu,\"conflict\":\"%s\",\"affected\":\"%s\",\"repeat\":%d,\"warmup\":%d,", r.graph.c_str(), r.order, r.size, r.batchSize, r.batchIndex, r.insertionFraction, r.insertions, r.deletions, r.reweights, o.workload.c_str(), r.threads, o.schedule.c_str(), o.chunkSize, o.numa.c_str(), o.balance, o.hubDegree, o.conflict.c_str(), o.affected.c_str(), o.repeat, o.warmup);
+    printf("\"technique\":\"%s\",\"time\":%g,\"min_time\":%g,\"median_time\":%g,\"stddev_time\":%g,\"iterations\":%d,\"passes\":%d,\"modularity\":%.9f,\"affected_vertices\":%zu,\"truncated\":%d,", technique, a.time, a.minTime, a.medianTime, a.stddevTime, a.iterations, a.passes, modularity, a.affectedVertices, a.truncated);
+    printf("\"graph_bytes\":%zu,\"aggregate_bytes\":%zu,\"workspace_bytes\":%zu,\"affected_bytes\":%zu,\"peak_rss\":%zu,", a.graphBytes, a.aggregateBytes, a.workspaceBytes, a.affectedBytes, r.peakResident);
+    printf("\"initialization_time\":%g,\"marking_time\":%g,\"local_move_time\":%g,\"aggregation_time\":%g,\"lookup_time\":%g,", a.initializationTime, a.markingTime, a.localMoveTime, a.aggregationTime, a.lookupTime);
+    if (isnan(r.staticModularity)) printf("\"drift\":null,");
+    else printf("\"drift\":%.9f,", modularity - r.staticModularity);
+    printf("\"auto_technique\":\"%s\",\"estimated_affected\":", louvainTechniqueName(a.technique)); writeNumber(stdout, a.estimatedAffected, true); printf(",");
+    if (s.baseThreads) printf("\"base_threads\":%d,", s.baseThreads);
+    else printf("\"base_threads\":null,");
+    for (int i=0; i<6; ++i) {
+      printf("\"%sspeedup\":", phases[i]);    writeNumber(stdout, s.baseThreads? s.speedup[i]    : NAN, true); printf(",");
+      printf("\"%sefficiency\":", phases[i]); writeNumber(stdout, s.baseThreads? s.efficiency[i] : NAN, true); printf(",");
+    }
+    writePerfCounts(stdout, a.passInitializationCounts, "initialization_", true);
+    writePerfCounts(stdout, a.passLocalMoveCounts,      "local_move_",     true);
+    writePerfCounts(stdout, a.passAggregationCounts,    "aggregation_",    true);
+    writePerfCounts(stdout, a.passLookupCounts,         "lookup_",         true);
+    printf("\"pass_time\":");       writeJsonValues(stdout, a.passTime);
+    printf(",\"pass_iterations\":"); writeJsonValues(stdout, a.passIterations);
+    printf(",\"pass_vertices\":");   writeJsonValues(stdout, a.passVertices);
+    printf(",\"thread_busy_time\":"); writeJsonValues(stdout, a.threadBusyTime);
+    printf(",\"imbalance\":");        writeNumber(stdout, busyImbalance(a.threadBusyTime), true);
+    printf("}\n");
+  }
+  else if (o.format=="csv") {
+    if (!header) printf("graph,order,size,batch_size,batch_index,insertion_fraction,insertions,deletions,reweights,workload,threads,schedule,chunk_size,numa,balance,hub_degree,conflict,affected,repeat,warmup,technique,time,min_time,median_time,stddev_time,iterations,passes,modularity,drift,auto_technique,estimated_affected,affected_vertices,truncated,graph_bytes,aggregate_bytes,workspace_bytes,affected_bytes,peak_rss,initialization_time,marking_time,local_move_time,aggregation_time,lookup_time,base_threads");
+    if (!header) for (int i=0; i<6; ++i) printf(",%sspeedup,%sefficiency", phases[i], phases[i]);
+    if (!header) for (int i : {1, 3, 4, 5}) printf(",%scycles,%sinstructions,%sllc_misses,%sbranch_misses", phases[i], phases[i], phases[i], phases[i]);
+    if (!header) printf(",pass_time,pass_iterations,pass_vertices,thread_busy_time,imbalance\n");
+    printf("%s,%zu,%zu,%g,%d,%g,%zu,%zu,%zu,%s,%d,%s,%d,%s,%d,%zu,%s,%s,%d,%d,", r.graph.c_str(), r.order, r.size, r.batchSize, r.batchIndex, r.insertionFraction, r.insertions, r.deletions, r.reweights, o.workload.c_str(), r.threads, o.schedule.c_str(), o.chunkSize, o.numa.c_str(), o.balance, o.hubDegree, o.conflict.c_str(), o.affected.c_str(), o.repeat, o.warmup);
+    printf("%s,%g,%g,%g,%g,%d,%d,%.9f,", technique, a.time, a.minTime, a.medianTime, a.stddevTime, a.iterations, a.passes, modularity);
+    if (!isnan(r.staticModularity)) printf("%.9f", modularity - r.staticModularity);
+    printf(",%s,", louvainTechniqueName(a.technique));
+    writeNumber(stdout, a.estimatedAffected, false);
+    printf(",%zu,%d,", a.affectedVertices, a.truncated);
+    printf("%zu,%zu,%zu,%zu,%zu,", a.graphBytes, a.aggregateBytes, a.workspaceBytes, a.affectedBytes, r.peakResident);
+    printf("%g,%g,%g,%g,%g,", a.initializationTime, a.markingTime, a.localMoveTime, a.aggregationTime, a.lookupTime);
+    if (s.baseThreads) printf("%d", s.baseThreads);
+    for (int i=0; i<6; ++i) {
+      printf(",");  writeNumber(stdout, s.baseThreads? s.speedup[i]    : NAN, false);
+      printf(",");  writeNumber(stdout, s.baseThreads? s.efficiency[i] : NAN, false);
+    }
+    printf(",");
+    writePerfCounts(stdout, a.passInitializationCounts, "", false); printf(",");
+    writePerfCounts(stdout, a.passLocalMoveCounts,      "", false); printf(",");
+    writePerfCounts(stdout, a.passAggregationCounts,    "", false); printf(",");
+    writePerfCounts(stdout, a.passLookupCounts,         "", false); printf(",");
+    writeCsvValues(stdout, a.passTime);       printf(",");
+    writeCsvValues(stdout, a.passIterations); printf(",");
+    writeCsvValues(stdout, a.passVertices);   printf(",");
+    writeCsvValues(stdout, a.threadBusyTime); printf(",");
+    writeNumber(stdout, busyImbalance(a.threadBusyTime), false); printf("\n");
+  }
+  else printResult(o, r, a, modularity, technique, s);
+  header = true;
+}
+
+
+
+
+// BATCH
+// -----
+// Generate a random batch of updates, with an edge sampler (as per workload).
+
+template <class G, class V, class FS>
+auto addRandomEdges(G& a, V w, int batchSize, FS fs) {
+  using K = typename G::key_type;
   int retries = 5;
   vector<tuple<K, K, V>> insertions;
+  bool added = false;
   auto fe = [&](auto u, auto v, auto w) {
+    added = u!=v && !a.hasEdge(u, v);
+    if (!added) return;
     a.addEdge(u, v, w);
     a.addEdge(v, u, w);
     insertions.push_back(make_tuple(u, v, w));
     insertions.push_back(make_tuple(v, u, w));
   };
   for (int i=0; i<batchSize; ++i)
-    retry([&]() { return addRandomEdge(a, rnd, span, w, fe); }, retries);
+    retry([&]() { added = false; fs(a, w, fe); return added; }, retries);
   a.correct();
   return insertions;
 }
 
 
-template <class G, class R>
-auto removeRandomEdges(G& a, R& rnd, int batchSize) {
+template <class G, class FS>
+auto removeRandomEdges(G& a, int batchSize, FS fs) {
   using K = typename G::key_type;
+  using V = typename G::edge_value_type;
   int retries = 5;
-  vector<tuple<K, K>> deletions;
+  vector<tuple<K, K, V>> deletions;
   auto fe = [&](auto u, auto v) {
+    V w = a.edgeValue(u, v);
     a.removeEdge(u, v);
     a.removeEdge(v, u);
-    deletions.push_back(make_tuple(u, v));
-    deletions.push_back(make_tuple(v, u));
+    deletions.push_back(make_tuple(u, v, w));
+    if (u!=v) deletions.push_back(make_tuple(v, u, w));
   };
   for (int i=0; i<batchSize; ++i)
-    retry([&]() { return removeRandomEdge(a, rnd, fe); }, retries);
+    retry([&]() { return fs(a, fe); }, retries);
   a.correct();
   return deletions;
 }
 
 
+// Increase weight of existing edges by one, or decrease it by half.
+template <class G, class R, class FS>
+auto changeRandomEdgeWeights(G& a, R& rnd, int batchSize, FS fs) {
+  using K = typename G::key_type;
+  using V = typename G::edge_value_type;
+  int retries = 5;
+  vector<tuple<K, K, V>> changes;
+  uniform_int_distribution<int> dis(0, 1);
+  auto fe = [&](auto u, auto v) {
+    V w = a.edgeValue(u, v);
+    V d = dis(rnd)? V(1) : -w/2;
+    a.setEdgeValue(u, v, w+d);
+    a.setEdgeValue(v, u, w+d);
+    changes.push_back(make_tuple(u, v, d));
+    if (u!=v) changes.push_back(make_tuple(v, u, d));
+  };
+  for (int i=0; i<batchSize; ++i)
+    retry([&]() { return fs(a, fe); }, retries);
+  return changes;
+}
+
+
+
+
+// EXPERIMENT
+// ----------
+
+// Communities (and aggregated graphs) each dynamic technique starts from.
+template <class G, class K>
+struct Chain {
+  using V = typename G::edge_value_type;
+  map<string, vector<K>> membership;  // by technique
+  map<string, G>         aggregate;   // by technique
+  LouvainWorkspace<K, V> ws;  // shared by all techniques
+};
+
+
+template <class G, class K, class V>
+LouvainResult<K> runTechnique(const string& t, const G& y, const EdgeBatch<K, V>& batch, const vector<K>* q, const LouvainOptions<V>& lo, G* z, LouvainWorkspace<K, V>* ws) {
+  const vector<K> *init = nullptr;
+  if (t=="louvainSeqStatic")       return louvainSeqStatic(y, init, lo, ws);
+  if (t=="louvainSeqNaiveDynamic") return louvainSeqStatic(y, q, lo, ws);
+  if (t=="louvainSeqDynamicDeltaScreening") return louvainSeqDynamicDeltaScreening(y, batch, q, lo, z, ws);
+  if (t=="louvainSeqDynamicFrontier")       return louvainSeqDynamicFrontier(y, batch, q, lo, z, ws);
+  if (t=="louvainSeqDynamicDeltaFrontier")  return louvainSeqDynamicDeltaFrontier(y, batch, q, lo, z, ws);
+  if (t=="louvainSeqDynamicAuto")           return louvainSeqDynamicAuto(y, batch, q, lo, z, ws);
+  if (t=="louvainOmpStatic")       return louvainOmpStatic(y, init, lo, ws);
+  if (t=="louvainOmpNaiveDynamic") return louvainOmpStatic(y, q, lo, ws);
+  if (t=="louvainOmpDynamicDeltaScreening") return louvainOmpDynamicDeltaScreening(y, batch, q, lo, z, ws);
+  if (t=="louvainOmpDynamicFrontier")       return louvainOmpDynamicFrontier(y, batch, q, lo, z, ws);
+  if (t=="louvainOmpDynamicDeltaFrontier")  return louvainOmpDynamicDeltaFrontier(y, batch, q, lo, z, ws);
+  if (t=="louvainOmpDynamicAuto")           return louvainOmpDynamicAuto(y, batch, q, lo, z, ws);
+  fprintf(stderr, "error: unknown technique \"%s\"\n", t.c_str()); exit(1);
+}
+
+
+template <class G, class K, class V>
+void runBatch(const Options& o, Record r, const G& y, const EdgeBatch<K, V>& batch, Chain<G, K>& c, bool runStatic=true) {
+  auto M = edgeWeight(y)/2;
+  auto lo = louvainOptions<V>(o);
+  Chain<G, K> b;
+  map<string, LouvainResult<K>> base;  // with first thread count
+  // Static techniques go first, to measure modularity drift of dynamic ones.
+  vector<string> ts;
+  for (const auto& t : o.techniques)
+    if (isStaticTechnique(t) && runStatic) ts.push_back(t);
+  for (const auto& t : o.techniques)
+    if (!isStaticTechnique(t)) ts.push_back(t);
+  for (int n : o.threads) {
+    setThreads(n, o.pin, o.schedule, o.chunkSize); r.threads = n;
+    r.staticModularity = NAN;
+    for (const auto& t : ts) {
+      bool st = isStaticTechnique(t);
+      memoryResetPeakResident();
+      G z = hasAggregate(t)? duplicate(c.aggregate[t]) : G();
+      auto a = runTechnique(t, y, batch, st? nullptr : &c.membership[t], lo, hasAggregate(t)? &z : nullptr, &c.ws);
+      r.peakResident = memoryPeakResidentBytes();
+      // Estimated affected fraction of each dynamic technique, to calibrate limits of auto.
+      if (!st && isnan(a.estimatedAffected)) a.estimatedAffected = louvainEstimateAffectedFraction(y, batch, c.membership[t]);
+      auto Q = getModularity(y, a, M);
+      Scaling s;
+      if (n==o.threads[0]) base.emplace(t, a);
+      else s = scaling(a, base.at(t), n, o.threads[0]);
+      writeResult(o, r, a, Q, t.c_str(), s);
+      if (st) { if (isnan(r.staticModularity)) r.staticModularity = Q; continue; }
+      b.membership[t] = move(a.membership);
+      if (hasAggregate(t)) b.aggregate[t] = move(z);
+    }
+  }
+  // Continue from the new communities (on the next chained batch).
+  for (auto& [t, q] : b.membership) c.membership[t] = move(q);
+  for (auto& [t, z] : b.aggregate)  c.aggregate[t]  = move(z);
+}
+
+
+// Stream generated batches into a scheduler, and report each coalesced run.
+template <class G, class K, class FB>
+void runStream(const Options& o, Record r, const G& x, const vector<K>& q, FB fb) {
+  using V = typename G::edge_value_type;
+  const char *t = "louvainSeqDynamicFrontier";
+  auto lo = louvainOptions<V>(o);
+  LouvainSchedulerOptions so(o.coalesceSize, o.coalesceAffected, float(o.latencyBudget));
+  setThreads(o.threads[0], o.pin, o.schedule, o.chunkSize); r.threads = o.threads[0];
+  memoryResetPeakResident();
+  auto y = duplicate(x);
+  LouvainScheduler<G, K, V> sch(y, q, lo, so);
+  size_t nb = 0, ni = 0, nd = 0, nr = 0;  // since last run
+  auto fw = [&](int trigger) {
+    if (trigger==LOUVAIN_TRIGGER_NONE) return;
+    const auto& a = sch.lastResult();
+    r.batchSize  = double(nb);
+    r.batchIndex = int(sch.stats().runs);
+    r.insertions = ni; r.deletions = nd; r.reweights = nr;
+    r.peakResident = memoryPeakResidentBytes();  // since start of stream
+    writeResult(o, r, a, getModularity(y, a, edgeWeight(y)/2), t);
+    nb = ni = nd = nr = 0;
+  };
+  fb([&](const auto& updates, size_t bat, size_t ins, size_t del, size_t rew) {
+    nb += bat; ni += ins; nd += del; nr += rew;
+    fw(sch.push(updates));
+  });
+  fw(sch.flush());
+  const auto& s = sch.stats();
+  FILE *log = o.format=="text"? stdout : stderr;
+  fprintf(log, "{stream: %zu runs; %zu received; %zu applied; triggers: %zu size, %zu affected, %zu latency, %zu flush}", s.runs, s.received, s.applied, s.triggers[LOUVAIN_TRIGGER_SIZE], s.triggers[LOUVAIN_TRIGGER_AFFECTED], s.triggers[LOUVAIN_TRIGGER_LATENCY], s.triggers[LOUVAIN_TRIGGER_FLUSH]);
+  fprintf(log, " {throughput: %.3e updates/s; processing: %09.3f ms; elapsed: %09.3f ms} {staleness: %09.3f ms mean; %09.3f ms max}\n", s.throughput(), s.processingTime, s.elapsedTime, s.stalenessMean(), s.stalenessMax);
+}
+
+
+// Stream generated batches through a pipeline for each dynamic technique,
+// staging the next batch while the current one is processed.
+template <class G, class K, class FB>
+void runPipeline(const Options& o, Record r, const G& x, const vector<K>& q, int B, FB fb) {
+  using V = typename G::edge_value_type;
+  auto lo = louvainOptions<V>(o);
+  setThreads(o.threads[0], o.pin, o.schedule, o.chunkSize); r.threads = o.threads[0];
+  FILE *log = o.format=="text"? stdout : stderr;
+  // Batch sizes and update counts, written by staging thread for batch i.
+  vector<double> bats(B);
+  vector<size_t> inss(B), dels(B), rews(B);
+  auto fe = [&](int i, double bat, size_t ins, size_t del, size_t rew) {
+    bats[i] = bat; inss[i] = ins; dels[i] = del; rews[i] = rew;
+  };
+  for (const auto& t : o.techniques) {
+    if (isStaticTechnique(t)) continue;
+    memoryResetPeakResident();
+    LouvainPipeline<G, K, V> pl(x, q);
+    auto fg = fb(fe);
+    auto fl = [&](const G& y, const auto& batch, const vector<K>& q, G& z, auto& ws) {
+      return runTechnique(t, y, batch, &q, lo, hasAggregate(t)? &z : nullptr, &ws);
+    };
+    auto fr = [&](int i, const G& y, const auto&, const auto& a) {
+      r.batchSize  = bats[i];
+      r.batchIndex = i+1;
+      r.insertions = inss[i]; r.deletions = dels[i]; r.reweights = rews[i];
+      r.peakResident = memoryPeakResidentBytes();  // since start of stream
+      writeResult(o, r, a, getModularity(y, a, edgeWeight(y)/2), t.c_str());
+    };
+    pl.run(B, fg, fl, fr);
+    const auto& s = pl.stats();
+    fprintf(log, "{pipeline: %s; %zu batches; %zu updates} {louvain: %09.3f ms; stage: %09.3f ms; wait: %09.3f ms; total: %09.3f ms} {throughput: %.3e updates/s; overlap: %.3f}\n", t.c_str(), s.batches, s.updates, s.louvainTime, s.stageTime, s.waitTime, s.totalTime, s.throughput(), s.overlap());
+  }
+}
 
 
 template <class G>
-void runLouvain(const G& x, int repeat) {
+void runLouvain(const Options& o, Record r, const G& x) {
   using K = typename G::key_type;
   using V = typename G::edge_value_type;
   vector<K> *init = nullptr;
   random_device dev;
   default_random_engine rnd(dev());
-  int retries  = 5;
   auto M = edgeWeight(x)/2;
   auto Q = modularity(x, M, 1.0f);
-  printf("[%01.6f modularity] noop\n", Q);
+  auto lo = louvainOptions<V>(o);
+  if (o.format=="text") printf("[%01.6f modularity] noop\n", Q);
+  else writeResult(o, r, LouvainResult<K>(vector<K>()), Q, "noop");
 
   // Get community memberships on original graph (static).
-  auto ak = louvainSeqStatic(x, init, {repeat});
-  printf("[%1.0e batch_size; %09.3f ms; %04d iters.; %03d passes; %01.9f modularity] louvainSeqStatic\n", 0.0, ak.time, ak.iterations, ak.passes, getModularity(x, ak, M));
-  // Batch of additions only (dynamic).
-  for (int batchSize=500, i=0; batchSize<=100000; batchSize*=i&1? 5:2, ++i) {
-    for (int batchCount=1; batchCount<=5; ++batchCount) {
+  setThreads(o.threads[0], o.pin, o.schedule, o.chunkSize); r.threads = o.threads[0];
+  memoryResetPeakResident();
+  auto ak = louvainSeqStatic(x, init, lo);
+  r.peakResident = memoryPeakResidentBytes();
+  writeResult(o, r, ak, getModularity(x, ak, M), "louvainSeqStatic");
+  r.peakResident = 0;
+  // Get aggregated graph as per original communities (for dynamic).
+  auto zk = louvainAggregate(x, ak.membership);
+  Chain<G, K> ck;
+  for (const auto& t : o.techniques) {
+    if (isStaticTechnique(t)) continue;
+    ck.membership[t] = ak.membership;
+    if (hasAggregate(t)) ck.aggregate[t] = zk;
+  }
+  // Sample updates uniformly, by degree, or within original communities.
+  auto ks = vertexKeys(x);
+  auto offsets = degreePrefixSum(x, ks);
+  vector<K> gks; vector<size_t> goff;
+  vertexKeysByGroup(gks, goff, x, ak.membership);
+  auto goffsets = degreePrefixSum(x, gks);
+  auto fi = [&](const auto& y, auto w, auto fe) {
+    if (o.workload=="degree")    return addRandomEdgeByDegree(y, rnd, ks, offsets, w, fe);
+    if (o.workload=="community") return addRandomEdgeWithinGroup(y, rnd, gks, goffsets, goff, ak.membership, w, fe);
+    return addRandomEdge(y, rnd, x.span(), w, fe);
+  };
+  auto fd = [&](const auto& y, auto fe) {
+    if (o.workload=="uniform") return removeRandomEdge(y, rnd, fe);
+    return removeRandomEdgeByDegree(y, rnd, ks, offsets, fe);
+  };
+  // Batch of insertions and/or deletions, applied together (dynamic).
+  // With a sequence length, batches are applied one after another to the
+  // same graph, each technique continuing from its own previous communities,
+  // and static Louvain is run periodically to measure modularity drift.
+  // With a coalescing limit, batches are instead streamed into a scheduler,
+  // which runs Dynamic Frontier Louvain on coalesced batches.
+  // With pipelining, the next chained batch is generated and applied to a
+  // shadow graph while dynamic Louvain runs on the current one.
+  bool stream = o.coalesceSize>0 || o.coalesceAffected>0 || o.latencyBudget>0;
+  bool chain  = o.sequenceLength>0 || stream || o.pipeline;
+  int  B = o.sequenceLength>0? o.sequenceLength : o.batchCount;
+  for (double f : o.insertionFractions) {
+    for (int batchSize : o.batchSizes) {
       auto y = duplicate(x);
-      auto insertions = addRandomEdges(y, rnd, x.span(), V(1), batchSize); vector<tuple<K, K>> deletions;
-      auto M = edgeWeight(y)/2;
-      // Find static Louvain.
-      auto al = louvainSeqStatic(y, init, {repeat});
-      printf("[%1.0e batch_size; %09.3f ms; %04d iters.; %03d passes; %01.9f modularity] louvainSeqStatic\n",                double(batchSize), al.time, al.iterations, al.passes, getModularity(y, al, M));
-      // Find naive-dynamic Louvain.
-      auto am = louvainSeqStatic(y, &ak.membership, {repeat});
-      printf("[%1.0e batch_size; %09.3f ms; %04d iters.; %03d passes; %01.9f modularity] louvainSeqNaiveDynamic\n",          double(batchSize), am.time, am.iterations, am.passes, getModularity(y, am, M));
-      // Find delta-screening based dynamic Louvain.
-      auto an = louvainSeqDynamicDeltaScreening(y, deletions, insertions, &ak.membership, {repeat});
-      printf("[%1.0e batch_size; %09.3f ms; %04d iters.; %03d passes; %01.9f modularity] louvainSeqDynamicDeltaScreening\n", double(batchSize), an.time, an.iterations, an.passes, getModularity(y, an, M));
-      // Find frontier based dynamic Louvain.
-      auto ao = louvainSeqDynamicFrontier(y, deletions, insertions, &ak.membership, {repeat});
-      printf("[%1.0e batch_size; %09.3f ms; %04d iters.; %03d passes; %01.9f modularity] louvainSeqDynamicFrontier\n",       double(batchSize), ao.time, ao.iterations, ao.passes, getModularity(y, ao, M));
+      auto c = ck;
+      if (stream) {
+        auto fb = [&](auto fe) {
+          for (int batchIndex=1; batchIndex<=B; ++batchIndex) {
+            int  nr = int(round(o.reweightFraction * batchSize));
+            int  ni = int(round(f * (batchSize-nr))), nd = batchSize - nr - ni;
+            auto changes    = changeRandomEdgeWeights(y, rnd, nr, fd);
+            auto deletions  = removeRandomEdges(y, nd, fd);
+            auto insertions = addRandomEdges(y, V(1), ni, fi);
+            fe(edgeUpdates(deletions, insertions, changes), batchSize, insertions.size(), deletions.size(), changes.size());
+          }
+        };
+        r.insertionFraction = f;
+        runStream(o, r, x, ak.membership, fb);
+        continue;
+      }
+      if (o.pipeline) {
+        // Each technique gets a fresh generator graph; batches are generated
+        // on the staging thread, which alone touches it (and rnd) meanwhile.
+        auto fb = [&](auto fe) {
+          y = duplicate(x);
+          return [&, fe](int batchIndex) {
+            int  nr = int(round(o.reweightFraction * batchSize));
+            int  ni = int(round(f * (batchSize-nr))), nd = batchSize - nr - ni;
+            auto changes    = changeRandomEdgeWeights(y, rnd, nr, fd);
+            auto deletions  = removeRandomEdges(y, nd, fd);
+            auto insertions = addRandomEdges(y, V(1), ni, fi);
+            fe(batchIndex, nd==batchSize? -batchSize : batchSize, insertions.size(), deletions.size(), changes.size());
+            return edgeUpdates(deletions, insertions, changes);
+          };
+        };
+        r.insertionFraction = f;
+        runPipeline(o, r, x, ak.membership, B, fb);
+        continue;
+      }
+      for (int batchIndex=1; batchIndex<=B; ++batchIndex) {
+        if (!chain) { y = duplicate(x); c = ck; }
+        int  nr = int(round(o.reweightFraction * batchSize));
+        int  ni = int(round(f * (batchSize-nr))), nd = batchSize - nr - ni;
+        auto changes    = changeRandomEdgeWeights(y, rnd, nr, fd);
+        auto deletions  = removeRandomEdges(y, nd, fd);
+        auto insertions = addRandomEdges(y, V(1), ni, fi);
+        auto updates    = edgeUpdates(deletions, insertions, changes);
+        auto batch      = edgeBatchOmp(updates, y.span(), true);
+        r.batchSize  = nd==batchSize? -batchSize : batchSize;
+        r.batchIndex = batchIndex;
+        r.insertionFraction = f;
+        r.insertions = insertions.size();
+        r.deletions  = deletions.size();
+        r.reweights  = changes.size();
+        bool runStatic = !chain || batchIndex % o.driftInterval==0 || batchIndex==B;
+        runBatch(o, r, y, batch, c, runStatic);
+      }
     }
   }
-  // Batch of deletions only (dynamic).
-  for (int batchSize=500, i=0; batchSize<=100000; batchSize*=i&1? 5:2, ++i) {
-    for (int batchCount=1; batchCount<=5; ++batchCount) {
-      auto y = duplicate(x);
-      auto deletions = removeRandomEdges(y, rnd, batchSize); vector<tuple<K, K, V>> insertions;
-      auto M = edgeWeight(y)/2;
-      // Find static Louvain.
-      auto al = louvainSeqStatic(y, init, {repeat});
-      printf("[%1.0e batch_size; %09.3f ms; %04d iters.; %03d passes; %01.9f modularity] louvainSeqStatic\n",                double(-batchSize), al.time, al.iterations, al.passes, getModularity(y, al, M));
-      // Find naive-dynamic Louvain.
-      auto am = louvainSeqStatic(y, &ak.membership, {repeat});
-      printf("[%1.0e batch_size; %09.3f ms; %04d iters.; %03d passes; %01.9f modularity] louvainSeqNaiveDynamic\n",          double(-batchSize), am.time, am.iterations, am.passes, getModularity(y, am, M));
-      // Find delta-screening based dynamic Louvain.
-      auto an = louvainSeqDynamicDeltaScreening(y, deletions, insertions, &ak.membership, {repeat});
-      printf("[%1.0e batch_size; %09.3f ms; %04d iters.; %03d passes; %01.9f modularity] louvainSeqDynamicDeltaScreening\n", double(-batchSize), an.time, an.iterations, an.passes, getModularity(y, an, M));
-      // Find frontier based dynamic Louvain.
-      auto ao = louvainSeqDynamicFrontier(y, deletions, insertions, &ak.membership, {repeat});
-      printf("[%1.0e batch_size; %09.3f ms; %04d iters.; %03d passes; %01.9f modularity] louvainSeqDynamicFrontier\n",       double(-batchSize), ao.time, ao.iterations, ao.passes, getModularity(y, ao, M));
+}
+
+
+// Run sequential Louvain on all graphs together, one task per graph, for each
+// thread count; the whole collection is timed (warmup, then mean of repeats).
+template <class G>
+void runMany(const Options& o, const vector<Record>& rs, const vector<G>& xs) {
+  using K = typename G::key_type;
+  using V = typename G::edge_value_type;
+  const char *t = "louvainSeqStaticMany";
+  auto lo = louvainOptions<V>(o);
+  lo.repeat = 1; lo.warmup = 0;
+  size_t N = xs.size();
+  float  t1 = 0;  // wall time with first thread count
+  FILE *log = o.format=="text"? stdout : stderr;
+  for (int n : o.threads) {
+    setThreads(n, o.pin, o.schedule, o.chunkSize);
+    vector<LouvainWorkspace<K, V>> wss;
+    vector<LouvainResult<K>> as;
+    auto fn = [&]() { as = louvainSeqStaticMany(xs, (const vector<const vector<K>*>*) nullptr, lo, &wss); };
+    memoryResetPeakResident();
+    for (int w=0; w<o.warmup; ++w) fn();
+    float tw = measureDuration(fn, o.repeat);
+    size_t pr = memoryPeakResidentBytes();
+    if (t1==0) t1 = tw;
+    float ts = 0;
+    for (size_t i=0; i<N; ++i) {
+      Record r = rs[i]; r.threads = n; r.peakResident = pr;
+      // Graphs are all loaded first, so text logs name the graph of each result.
+      if (o.format=="text") printf("{many: graph %s; order: %zu; size: %zu}\n", r.graph.c_str(), r.order, r.size);
+      writeResult(o, r, as[i], getModularity(xs[i], as[i], edgeWeight(xs[i])/2), t);
+      ts += as[i].time;
     }
+    fprintf(log, "{many: %zu graphs; %d threads} {wall: %09.3f ms; tasks: %09.3f ms} {throughput: %.3e graphs/s; speedup: %.3f}\n", N, n, tw, ts, tw>0? 1000.0*N/tw : 0, tw>0? t1/tw : 0);
   }
 }
 
 
+string graphName(const string& pth) {
+  size_t i = pth.find_last_of("/\\");
+  string a = i==string::npos? pth : pth.substr(i+1);
+  size_t e = a.rfind(".mtx");
+  return e==string::npos? a : a.substr(0, e);
+}
+
+
 int main(int argc, char **argv) {
   using K = int;
   using V = float;
-  char *file = argv[1];
-  int repeat = argc>2? stoi(argv[2]) : 5;
-  OutDiGraph<K, None, V> x; V w = 1;
-  printf("Loading graph %s ...\n", file);
-  readMtxW(x, file); println(x);
-  auto y  = symmetricize(x); print(y); printf(" (symmetricize)\n");
-  auto fl = [](auto u) { return true; };
-  // selfLoopU(y, w, fl); print(y); printf(" (selfLoopAllVertices)\n");
-  runLouvain(y, repeat);
-  printf("\n");
+  Options o = readOptions(argc, argv);
+  if (o.files.empty()) {
+    printUsage(argv[0]);
+    return 1;
+  }
+  // Progress is logged on stderr, when results are machine-readable.
+  bool text = o.format=="text";
+  FILE *log = text? stdout : stderr;
+  // With many, all graphs are loaded first, and processed together.
+  vector<OutDiGraph<K, None, V>> ys;
+  vector<Record> rs;
+  for (const auto& file : o.files) {
+    OutDiGraph<K, None, V> x;
+    fprintf(log, "Loading graph %s ...\n", file.c_str());
+    memoryResetPeakResident();
+    readMtxOmpW(x, file.c_str());
+    fprintf(log, "order: %d size: %zu [directed] {}\n", x.order(), x.size());
+    auto y  = symmetricizeOmp(x);
+    fprintf(log, "order: %d size: %zu [directed] {} (symmetricize)\n", y.order(), y.size());
+    fprintf(log, "{memory: %zu input; %zu symmetric; %zu peak_rss bytes} (load)\n", x.bytes(), y.bytes(), memoryPeakResidentBytes());
+    // auto fl = [](auto u) { return true; };
+    // selfLoopU(y, w, fl); print(y); printf(" (selfLoopAllVertices)\n");
+    Record r;
+    r.graph = graphName(file);
+    r.order = y.order();
+    r.size  = y.size();
+    if (o.many) { ys.push_back(move(y)); rs.push_back(r); continue; }
+    runLouvain(o, r, y);
+    fprintf(log, "\n");
+  }
+  if (o.many) runMany(o, rs, ys);
   return 0;
 }
@@ -4,8 +4,21 @@ const path = require('path');
 
 const RGRAPH = /^Loading graph .*\/(.*?)\.mtx \.\.\./m;
 const RORDER = /^order: (\d+) size: (\d+) (?:\[\w+\] )?\{\} \(symmetricize\)/m;
+const RMANYG = /^\{many: graph (\S+); order: (\d+); size: (\d+)\}/;
 const RORGNL = /^\[(\S+?) modularity\] noop/;
 const RRESLT = /^\[(\S+?) batch_size; (\S+?) ms; (\d+) iters\.; (\d+) passes; (\S+?) modularity\] (\w+)/m;
+const RTHRDS = /\{threads: (\d+); schedule: (\w+),(\d+)(?:; numa: ([\w-]+))?(?:; balance: (\d+); hub_degree: (\d+))?(?:; conflict: (\w+))?(?:; affected: (\w+))?\}/;
+const RBUSY  = /\{busy: (\S+?) ms min; (\S+?) ms mean; (\S+?) ms max; (\S+?) imbalance\}/;
+const RBATCH = /\{batch: (\d+) insertions; (\d+) deletions(?:; (\d+) reweights)?\}/;
+const RDRIFT = /\{drift: (\S+?) modularity\}/;
+const RAUTO  = /\{auto: ([\w-]+); estimated_affected: (\S+?)\}/;
+const RTRUNC = /\{truncated\}/;
+const RMEMRY = /\{memory: (\d+) graph; (\d+) aggregate; (\d+) workspace; (\d+) affected; (\d+) peak_rss bytes\}/;
+const RSTATS = /\{min: (\S+?) ms; median: (\S+?) ms; stddev: (\S+?) ms\}/;
+const RPHASE = /\{init: (\S+?) ms; mark: (\S+?) ms; move: (\S+?) ms; aggr: (\S+?) ms; look: (\S+?) ms\}/;
+const RSPEED = /\{speedup: (\S+?)x; init: (\S+?)x; mark: (\S+?)x; move: (\S+?)x; aggr: (\S+?)x; look: (\S+?)x; vs (\d+) threads\}/;
+const REFFIC = /\{efficiency: (\S+?); init: (\S+?); mark: (\S+?); move: (\S+?); aggr: (\S+?); look: (\S+?)\}/;
+const RPASS  = /\{pass: (\S+?) ms; (\d+) iters\.; (\d+) vertices\}/g;
 
 
 
@@ -43,12 +56,36 @@ function writeCsv(pth, rows) {
 // *-LOG
 // -----
 
+function readJsonLine(ln, data) {
+  var r = JSON.parse(ln);
+  for (var k in r)
+    if (Array.isArray(r[k])) r[k] = r[k].join(';');
+  if (!data.has(r.graph)) data.set(r.graph, []);
+  data.get(r.graph).push(r);
+}
+
+// Speedup and efficiency of each phase (empty without a thread sweep).
+function scalingFields(speedup, efficiency) {
+  var phases = ['', 'initialization_', 'marking_', 'local_move_', 'aggregation_', 'lookup_'], a = {};
+  for (var i=0; i<phases.length; ++i) {
+    a[phases[i]+'speedup']    = speedup[i]!=null?    parseFloat(speedup[i])    : '';
+    a[phases[i]+'efficiency'] = efficiency[i]!=null? parseFloat(efficiency[i]) : '';
+  }
+  return a;
+}
+
 function readLogLine(ln, data, state) {
-  if (RGRAPH.test(ln)) {
+  if (ln.startsWith('{"')) readJsonLine(ln, data);
+  else if (RGRAPH.test(ln)) {
     var [, graph] = RGRAPH.exec(ln);
     if (!data.has(graph)) data.set(graph, []);
     state = {graph};
   }
+  else if (RMANYG.test(ln)) {
+    var [, graph, order, size] = RMANYG.exec(ln);
+    if (!data.has(graph)) data.set(graph, []);
+    state = {graph, order: parseFloat(order), size: parseFloat(size)};
+  }
   else if (RORDER.test(ln)) {
     var [, order, size] = RORDER.exec(ln);
     state.order = parseFloat(order);
@@ -58,22 +95,113 @@ function readLogLine(ln, data, state) {
     var [, modularity] = RORGNL.exec(ln);
     data.get(state.graph).push(Object.assign({}, state, {
       batch_size:  0,
+      threads:     '',
+      schedule:    '',
+      chunk_size:  '',
+      numa:        '',
+      balance:     '',
+      hub_degree:  '',
+      conflict:    '',
+      affected:    '',
+      insertions:  0,
+      deletions:   0,
+      reweights:   0,
       time:        0,
+      min_time:    0,
+      median_time: 0,
+      stddev_time: 0,
       iterations:  0,
       passes:      0,
       modularity:  parseFloat(modularity),
+      drift:       '',
+      auto_technique:     '',
+      estimated_affected: '',
+      truncated:   0,
+      graph_bytes:     '',
+      aggregate_bytes: '',
+      workspace_bytes: '',
+      affected_bytes:  '',
+      peak_rss:        '',
       technique:   'noop',
+      initialization_time: 0,
+      marking_time:        0,
+      local_move_time:     0,
+      aggregation_time:    0,
+      lookup_time:         0,
+      base_threads: '',
+      ...scalingFields([], []),
+      pass_time:       '',
+      pass_iterations: '',
+      pass_vertices:   '',
+      busy_min:  '',
+      busy_mean: '',
+      busy_max:  '',
+      imbalance: '',
     }));
   }
   else if (RRESLT.test(ln)) {
     var [, batch_size, time, iterations, passes, modularity, technique] = RRESLT.exec(ln);
+    var [, threads, schedule, chunk_size, numa, balance, hub_degree, conflict, affected] = RTHRDS.exec(ln) || [];
+    var [, busy_min, busy_mean, busy_max, imbalance] = RBUSY.exec(ln) || [];
+    var [, insertions, deletions, reweights] = RBATCH.exec(ln) || [];
+    var [, drift] = RDRIFT.exec(ln) || [];
+    var [, auto_technique, estimated_affected] = RAUTO.exec(ln) || [];
+    var [, min_time, median_time, stddev_time] = RSTATS.exec(ln) || [];
+    var [, graph_bytes, aggregate_bytes, workspace_bytes, affected_bytes, peak_rss] = RMEMRY.exec(ln) || [];
+    var [, initialization_time, marking_time, local_move_time, aggregation_time, lookup_time] = RPHASE.exec(ln) || [];
+    var [, ...speedup]    = RSPEED.exec(ln) || [];
+    var [, ...efficiency] = REFFIC.exec(ln) || [];
+    var base_threads = speedup.length? speedup.pop() : '';
+    var pass_time = [], pass_iterations = [], pass_vertices = [];
+    for (var [, t, l, n] of ln.matchAll(RPASS)) {
+      pass_time.push(parseFloat(t));
+      pass_iterations.push(parseFloat(l));
+      pass_vertices.push(parseFloat(n));
+    }
     data.get(state.graph).push(Object.assign({}, state, {
       batch_size:  parseFloat(batch_size),
+      threads:     threads? parseFloat(threads) : '',
+      schedule:    schedule || '',
+      chunk_size:  chunk_size? parseFloat(chunk_size) : '',
+      numa:        numa || '',
+      balance:     balance? parseFloat(balance) : '',
+      hub_degree:  hub_degree? parseFloat(hub_degree) : '',
+      conflict:    conflict || '',
+      affected:    affected || '',
+      insertions:  parseFloat(insertions || 0),
+      deletions:   parseFloat(deletions || 0),
+      reweights:   parseFloat(reweights || 0),
       time:        parseFloat(time),
+      min_time:    parseFloat(min_time || time),
+      median_time: parseFloat(median_time || time),
+      stddev_time: parseFloat(stddev_time || 0),
       iterations:  parseFloat(iterations),
       passes:      parseFloat(passes),
       modularity:  parseFloat(modularity),
+      drift:       drift!=null? parseFloat(drift) : '',
+      auto_technique:     auto_technique && auto_technique!=='-'? auto_technique : '',
+      estimated_affected: estimated_affected? parseFloat(estimated_affected) : '',
+      truncated:   RTRUNC.test(ln)? 1 : 0,
+      graph_bytes:     graph_bytes?     parseFloat(graph_bytes)     : '',
+      aggregate_bytes: aggregate_bytes? parseFloat(aggregate_bytes) : '',
+      workspace_bytes: workspace_bytes? parseFloat(workspace_bytes) : '',
+      affected_bytes:  affected_bytes?  parseFloat(affected_bytes)  : '',
+      peak_rss:        peak_rss?        parseFloat(peak_rss)        : '',
       technique,
+      initialization_time: parseFloat(initialization_time || 0),
+      marking_time:        parseFloat(marking_time || 0),
+      local_move_time:     parseFloat(local_move_time || 0),
+      aggregation_time:    parseFloat(aggregation_time || 0),
+      lookup_time:         parseFloat(lookup_time || 0),
+      base_threads: base_threads? parseFloat(base_threads) : '',
+      ...scalingFields(speedup, efficiency),
+      pass_time:       pass_time.join(';'),
+      pass_iterations: pass_iterations.join(';'),
+      pass_vertices:   pass_vertices.join(';'),
+      busy_min:  busy_min?  parseFloat(busy_min)  : '',
+      busy_mean: busy_mean? parseFloat(busy_mean) : '',
+      busy_max:  busy_max?  parseFloat(busy_max)  : '',
+      imbalance: imbalance? parseFloat(imbalance) : '',
     }));
   }
   return state;
@@ -103,6 +231,42 @@ function processCsv(data) {
 }
 
 
+// Calibrate limits of automatic technique selection (--auto-limits), from the
+// fastest technique on each batch and its estimated affected fraction. Rows of
+// a batch are consecutive in the log, so a batch ends when a technique repeats.
+// Each limit is the one that misclassifies the fewest batches.
+function processCalibrate(data) {
+  var TECHS = ['DynamicFrontier', 'DynamicDeltaScreening', 'NaiveDynamic', 'Static'];
+  var groups = [], points = [];
+  for (var rows of data.values()) {
+    var g = null;
+    for (var r of rows) {
+      var m = /^louvain(Seq|Omp)(\w+)$/.exec(r.technique);
+      if (!m || TECHS.indexOf(m[2]) < 0) continue;
+      if (!g || g.seen.has(r.technique)) groups.push(g = {seen: new Set(), time: Infinity, rank: -1, estimate: NaN});
+      g.seen.add(r.technique);
+      if (r.estimated_affected!=='' && r.estimated_affected!=null) g.estimate = parseFloat(r.estimated_affected);
+      if (r.time < g.time) { g.time = r.time; g.rank = TECHS.indexOf(m[2]); }
+    }
+  }
+  for (var g of groups)
+    if (!isNaN(g.estimate)) points.push(g);
+  var limits = [], lo = 0;
+  for (var b=0; b<TECHS.length-1; ++b) {
+    var best = lo, errors = Infinity;
+    for (var t of [lo, ...points.map(p => p.estimate).filter(f => f>=lo)]) {
+      var e = points.filter(p => (p.rank<=b) !== (p.estimate<=t)).length;
+      if (e < errors) { errors = e; best = t; }
+    }
+    if (!points.some(p => p.rank>b)) best = 1;
+    limits.push(best); lo = best;
+  }
+  var wins = TECHS.map((t, i) => `${t}: ${points.filter(p => p.rank===i).length}`);
+  console.log(`batches: ${points.length} {${wins.join('; ')}}`);
+  console.log(`--auto-limits ${limits.join(',')}`);
+}
+
+
 
 
 // MAIN
@@ -110,6 +274,7 @@ function processCsv(data) {
 
 function main(cmd, log, out) {
   var data = readLog(log);
+  if (cmd==='calibrate') return processCalibrate(data);
   if (path.extname(out)==='') cmd += '-dir';
   switch (cmd) {
     case 'csv':
@@ -69,6 +69,27 @@ using std::cout;
 #endif
 
 
+#ifndef GRAPH_BYTES
+#define GRAPH_BYTES(K, V, E, vexists, vvalues, eto) \
+  inline size_t bytes() const noexcept { \
+    size_t a = sizeof(*this) + vexists.capacity()/8 + vvalues.capacity()*sizeof(V); \
+    a += eto.capacity() * sizeof(eto[0]); \
+    for (const auto& es : eto) a += es.capacity() * sizeof(pair<K, E>); \
+    return a; \
+  }
+#define GRAPH_BYTES_INOUT(K, V, E, vexists, vvalues, eto, efrom) \
+  inline size_t bytes() const noexcept { \
+    size_t a = sizeof(*this) + vexists.capacity()/8 + vvalues.capacity()*sizeof(V); \
+    a += (eto.capacity() + efrom.capacity()) * sizeof(eto[0]); \
+    for (const auto& es : eto)   a += es.capacity() * sizeof(pair<K, E>); \
+    for (const auto& es : efrom) a += es.capacity() * sizeof(pair<K, E>); \
+    return a; \
+  }
+#define GRAPH_BYTES_FROM(K, V, E, x) \
+  inline size_t bytes() const noexcept { return x.bytes(); }
+#endif
+
+
 #ifndef GRAPH_ENTRIES
 #define GRAPH_CVERTICES(K, V, E, vexists, vvalues) \
   inline auto cvertexKeys() const noexcept { \
@@ -376,6 +397,25 @@ using std::cout;
 #endif
 
 
+// Correct edges of vertices in parallel, each vertex by a single thread.
+#ifndef GRAPH_CORRECT_OMP
+#define GRAPH_CORRECT_OMP(K, V, E, M, unq, u, e0) \
+  inline bool correctOmp(bool unq=false) { \
+    bool a = false; size_t m = 0; \
+    K S = span(); \
+    _Pragma("omp parallel for schedule(dynamic, 2048) reduction(||:a) reduction(+:m)") \
+    for (K u=0; u<S; ++u) { \
+      if (!hasVertex(u)) continue; \
+      bool b = e0; \
+      a = a || b; \
+      m += degree(u); \
+    } \
+    M = m; \
+    return a; \
+  }
+#endif
+
+
 #ifndef GRAPH_RESIZE
 #define GRAPH_RESIZE_X(K, V, E, n, vexists, vvalues, eto, extra) \
   inline bool resize(size_t n) { \
@@ -438,6 +478,32 @@ using std::cout;
 #endif
 
 
+// Add an edge from a thread that alone adds out-edges of u (both vertices must exist).
+// Edge count is left as is, until correct() is called after all edges are added.
+#ifndef GRAPH_ADD_EDGE_OMP
+#define GRAPH_ADD_EDGE_OMP_X(K, V, E, u, v, d, ee) \
+  inline bool addEdgeOmp(const K& u, const K& v, const E& d=E()) { \
+    if (!hasVertex(u) || !hasVertex(v)) return false; \
+    return ee; \
+  }
+#define GRAPH_ADD_EDGE_OMP_SEARCH(K, V, E, eto) \
+  GRAPH_ADD_EDGE_OMP_X(K, V, E, u, v, d, eto[u].add(v, d))
+#endif
+
+
+// Remove an edge from a thread that alone removes out-edges of u.
+// Edge count is left as is, until correct() is called after all edges are removed.
+#ifndef GRAPH_REMOVE_EDGE_OMP
+#define GRAPH_REMOVE_EDGE_OMP_X(K, V, E, u, v, ee) \
+  inline bool removeEdgeOmp(const K& u, const K& v) { \
+    if (!hasVertex(u) || !hasVertex(v)) return false; \
+    return ee; \
+  }
+#define GRAPH_REMOVE_EDGE_OMP_SEARCH(K, V, E, eto) \
+  GRAPH_REMOVE_EDGE_OMP_X(K, V, E, u, v, eto[u].remove(v))
+#endif
+
+
 #ifndef GRAPH_REMOVE_EDGE
 #define GRAPH_REMOVE_EDGE_X(K, V, E, u, v, M, ee) \
   inline bool removeEdge(const K& u, const K& v) { \
@@ -562,6 +628,7 @@ class DiGraph {
   public:
   GRAPH_SIZES(K, V, E, N, M, vexists)
   GRAPH_DIRECTEDNESS(K, V, E, true)
+  GRAPH_BYTES_INOUT(K, V, E, vexists, vvalues, eto, efrom)
 
 
   // Scan operations.
@@ -639,6 +706,7 @@ class OutDiGraph {
   public:
   GRAPH_SIZES(K, V, E, N, M, vexists)
   GRAPH_DIRECTEDNESS(K, V, E, true)
+  GRAPH_BYTES(K, V, E, vexists, vvalues, eto)
 
 
   // Scan operations.
@@ -671,11 +739,14 @@ class OutDiGraph {
   // Update operations.
   public:
   GRAPH_CORRECT(K, V, E, M, unq, buf, u, eto[u].correct(unq, buf), false)
+  GRAPH_CORRECT_OMP(K, V, E, M, unq, u, eto[u].correct(unq))
   GRAPH_CLEAR_SEARCH(K, V, E, N, M, vexists, vvalues, eto)
   GRAPH_RESIZE_SEARCH(K, V, E, vexists, vvalues, eto)
   GRAPH_ADD_VERTEX(K, V, E, N, vexists, vvalues)
   GRAPH_ADD_EDGE_SEARCH(K, V, E, M, eto)
+  GRAPH_ADD_EDGE_OMP_SEARCH(K, V, E, eto)
   GRAPH_REMOVE_EDGE_SEARCH(K, V, E, M, eto)
+  GRAPH_REMOVE_EDGE_OMP_SEARCH(K, V, E, eto)
   GRAPH_REMOVE_EDGES_SEARCH(K, V, E, M, eto)
   GRAPH_REMOVE_INEDGES_SEARCH(K, V, E, M, eto)
   GRAPH_REMOVE_VERTEX(K, V, E, N, vexists, vvalues)
@@ -776,6 +847,7 @@ class GraphView {
   public:
   GRAPH_SIZES_FROM(K, V, E, x)
   GRAPH_DIRECTEDNESS_FROM(K, V, E, x)
+  GRAPH_BYTES_FROM(K, V, E, x)
 
 
   // Scan operations.
@@ -843,6 +915,7 @@ class TransposedGraphView {
   public:
   GRAPH_SIZES_FROM(K, V, E, x)
   GRAPH_DIRECTEDNESS_FROM(K, V, E, x)
+  GRAPH_BYTES_FROM(K, V, E, x)
 
 
   // Scan operations.
@@ -45,7 +45,8 @@ using std::inplace_merge;
 
 #ifndef BITSET_SIZE
 #define BITSET_SIZE(K, V, data)  \
-  inline size_t size() const noexcept { return data.size(); }
+  inline size_t size() const noexcept { return data.size(); } \
+  inline size_t capacity() const noexcept { return data.capacity(); }
 
 #define BITSET_EMPTY(K, V) \
   inline bool empty()  const noexcept { return size() == 0; }
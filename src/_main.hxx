@@ -12,3 +12,6 @@
 #include "_vector.hxx"
 #include "_queue.hxx"
 #include "_bitset.hxx"
+#include "_perf.hxx"
+#include "_numa.hxx"
+#include "_memory.hxx"
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <vector>
+
+using std::vector;
+
+
+
+
+// MEMORY-BYTES
+// ------------
+// Bytes allocated by a container (its capacity, not its size).
+
+template <class T>
+inline size_t vectorBytes(const vector<T>& x) {
+  return x.capacity() * sizeof(T);
+}
+inline size_t vectorBytes(const vector<bool>& x) {
+  return x.capacity() / 8;
+}
+
+template <class T>
+inline size_t vectorBytes(const vector<vector<T>>& x) {
+  size_t a = x.capacity() * sizeof(vector<T>);
+  for (const auto& y : x) a += vectorBytes(y);
+  return a;
+}
+
+
+
+
+// MEMORY-RESIDENT
+// ---------------
+// Resident set size (RSS) of the process, as reported by the kernel.
+// The peak (high water mark) can be reset on Linux, so that the peak of each
+// phase of a program can be found. Elsewhere, sizes are reported as 0.
+
+/**
+ * Read a size field of /proc/self/status.
+ * @param key name of field, with colon (e.g. "VmRSS:")
+ * @returns size in bytes, or 0 if not available
+ */
+inline size_t memoryStatusBytes(const char *key) {
+  #ifdef __linux__
+  FILE *f = fopen("/proc/self/status", "r");
+  if (!f) return 0;
+  char ln[256]; size_t a = 0, n = strlen(key);
+  while (fgets(ln, sizeof(ln), f)) {
+    if (strncmp(ln, key, n)!=0) continue;
+    unsigned long kb = 0;
+    if (sscanf(ln+n, "%lu", &kb)==1) a = size_t(kb) * 1024;
+    break;
+  }
+  fclose(f);
+  return a;
+  #else
+  return 0;
+  #endif
+}
+
+
+/**
+ * Get the current resident set size of the process.
+ * @returns size in bytes, or 0 if not available
+ */
+inline size_t memoryResidentBytes() {
+  return memoryStatusBytes("VmRSS:");
+}
+
+
+/**
+ * Get the peak resident set size of the process, since start or last reset.
+ * @returns size in bytes, or 0 if not available
+ */
+inline size_t memoryPeakResidentBytes() {
+  return memoryStatusBytes("VmHWM:");
+}
+
+
+/**
+ * Reset the peak resident set size of the process to its current size.
+ * @returns true if reset
+ */
+inline bool memoryResetPeakResident() {
+  #ifdef __linux__
+  FILE *f = fopen("/proc/self/clear_refs", "w");
+  if (!f) return false;
+  bool a = fputs("5", f)>=0;
+  return fclose(f)==0 && a;
+  #else
+  return false;
+  #endif
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "_debug.hxx"
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
+
+
+
+// NUMA-POLICY
+// -----------
+// Placement of large buffers on a multi-socket machine.
+// Linux places a page on the NUMA node of the thread that first touches it.
+// With first-touch, buffers are touched in parallel by the threads that later
+// process them (same static partitioning), and with interleave their pages are
+// spread round-robin across all allowed nodes. If the kernel does not support
+// (or permit) a policy, pages are simply placed as usual.
+
+#define NUMA_DEFAULT     0
+#define NUMA_FIRST_TOUCH 1
+#define NUMA_INTERLEAVE  2
+
+
+
+
+// NUMA-PAGES
+// ----------
+
+/**
+ * Find the page-aligned part of a memory range.
+ * @param x start of range
+ * @param N size of range in bytes
+ * @param b start of page-aligned part (output)
+ * @returns size of page-aligned part in bytes
+ */
+inline size_t numaPageRange(void *x, size_t N, char*& b) {
+  #ifdef __linux__
+  size_t P = size_t(sysconf(_SC_PAGESIZE));
+  uintptr_t s = (uintptr_t(x) + P-1) / P * P;
+  uintptr_t e = (uintptr_t(x) + N) / P * P;
+  b = (char*) s;
+  return e>s? e-s : 0;
+  #else
+  b = (char*) x;
+  return 0;
+  #endif
+}
+
+
+/**
+ * Release physical pages of a buffer, so that they are placed again on next touch.
+ * Only whole pages within the buffer are released, and they read as zero after it.
+ * @param x start of buffer (private, anonymous memory)
+ * @param N size of buffer in bytes
+ * @returns true if pages were released
+ */
+inline bool numaReleasePages(void *x, size_t N) {
+  #ifdef __linux__
+  char *b; size_t B = numaPageRange(x, N, b);
+  return B>0 && madvise(b, B, MADV_DONTNEED)==0;
+  #else
+  return false;
+  #endif
+}
+
+
+/**
+ * Interleave pages of a buffer (touched after this) across allowed NUMA nodes.
+ * @param x start of buffer
+ * @param N size of buffer in bytes
+ * @returns true if policy was set
+ */
+inline bool numaInterleavePages(void *x, size_t N) {
+  #ifdef __linux__
+  char *b; size_t B = numaPageRange(x, N, b);
+  unsigned long nodes[16] = {};
+  const unsigned long maxnode = 8 * sizeof(nodes);
+  if (B==0) return false;
+  if (syscall(__NR_get_mempolicy, nullptr, nodes, maxnode, nullptr, MPOL_F_MEMS_ALLOWED)!=0) return false;
+  return syscall(__NR_mbind, b, B, MPOL_INTERLEAVE, nodes, maxnode, 0)==0;
+  #else
+  return false;
+  #endif
+}
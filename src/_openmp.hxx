@@ -22,6 +22,29 @@ using std::sqrt;
 
 
 
+// THREAD-INFO
+// -----------
+// Usable without OpenMP (as a single thread).
+
+inline int ompThreadNum() noexcept {
+  #ifdef _OPENMP
+  return omp_get_thread_num();
+  #else
+  return 0;
+  #endif
+}
+
+inline int ompMaxThreads() noexcept {
+  #ifdef _OPENMP
+  return omp_get_max_threads();
+  #else
+  return 1;
+  #endif
+}
+
+
+
+
 // VECTOR OPERATIONS
 // -----------------
 
@@ -330,6 +353,135 @@ inline void constrainMinOmp(vector<T>& a, size_t i, size_t N, const V& v) {
 
 
 
+// EXCLUSIVE-SCAN
+// --------------
+// Each thread scans its own block, after the sums of blocks before it.
+
+template <class T, class TA>
+void exclusiveScanOmp(const T *x, TA *a, size_t N) {
+  ASSERT(x && a);
+  if (N<SIZE_MIN_OMPM) { exclusiveScan(x, a, N); return; }
+  int P = ompMaxThreads();
+  vector<TA> sums(P+1);
+  #pragma omp parallel for schedule(static, 1)
+  for (int p=0; p<P; ++p) {
+    size_t i0 = N*p/P, i1 = N*(p+1)/P;
+    TA sum = TA();
+    for (size_t i=i0; i<i1; ++i)
+      sum += x[i];
+    sums[p+1] = sum;
+  }
+  for (int p=0; p<P; ++p)
+    sums[p+1] += sums[p];
+  #pragma omp parallel for schedule(static, 1)
+  for (int p=0; p<P; ++p) {
+    size_t i0 = N*p/P, i1 = N*(p+1)/P;
+    TA sum = sums[p];
+    for (size_t i=i0; i<i1; ++i) {
+      T v  = x[i];
+      a[i] = sum;
+      sum += v;
+    }
+  }
+}
+template <class T, class TA>
+inline void exclusiveScanOmp(const vector<T>& x, vector<TA>& a) {
+  exclusiveScanOmp(x.data(), a.data(), x.size());
+}
+template <class T, class TA>
+inline void exclusiveScanOmp(const vector<T>& x, vector<TA>& a, size_t i, size_t N) {
+  exclusiveScanOmp(x.data()+i, a.data()+i, N);
+}
+
+template <class TA, class T>
+inline void exclusiveScanOmpW(TA *a, const T *x, size_t N) {
+  ASSERT(a && x);
+  exclusiveScanOmp(x, a, N);
+}
+template <class TA, class T>
+inline void exclusiveScanOmpW(vector<TA>& a, const vector<T>& x) {
+  exclusiveScanOmp(x, a);
+}
+template <class TA, class T>
+inline void exclusiveScanOmpW(vector<TA>& a, const vector<T>& x, size_t i, size_t N) {
+  exclusiveScanOmp(x, a, i, N);
+}
+
+
+
+
+// FILTER-INDICES
+// --------------
+// Indices where a condition holds, in order.
+
+template <class F>
+void filterIndicesOmpW(vector<size_t>& a, size_t N, F fn) {
+  vector<size_t> offsets(N+1);
+  #pragma omp parallel for schedule(auto)
+  for (size_t i=0; i<N; ++i)
+    offsets[i] = fn(i)? 1 : 0;
+  offsets[N] = 0;
+  exclusiveScanOmp(offsets, offsets);
+  a.resize(offsets[N]);
+  #pragma omp parallel for schedule(auto)
+  for (size_t i=0; i<N; ++i)
+    if (offsets[i+1] > offsets[i]) a[offsets[i]] = i;
+}
+
+
+
+
+// RADIX-SORT
+// ----------
+// Stable LSD radix sort on an unsigned key, 8 bits at a time.
+// Each thread counts and scatters its own block of values.
+
+/**
+ * Sort values by key in parallel.
+ * @param a values to sort (updated)
+ * @param buf temporary buffer (updated)
+ * @param fk get key of a value, as size_t
+ * @param B number of key bits to sort on
+ */
+template <class T, class FK>
+void radixSortOmpU(vector<T>& a, vector<T>& buf, FK fk, int B) {
+  const int    R = 8;
+  const size_t D = size_t(1) << R;
+  size_t N = a.size();
+  int    P = N<SIZE_MIN_OMPM? 1 : ompMaxThreads();
+  vector<size_t> counts;
+  buf.resize(N);
+  for (int s=0; s<B; s+=R) {
+    counts.assign(P*D, 0);
+    #pragma omp parallel for schedule(static, 1) if(P>1)
+    for (int p=0; p<P; ++p) {
+      size_t i0 = N*p/P, i1 = N*(p+1)/P;
+      size_t *cp = &counts[p*D];
+      for (size_t i=i0; i<i1; ++i)
+        ++cp[(fk(a[i]) >> s) & (D-1)];
+    }
+    // Offsets are ordered by digit, and then by block (for stability).
+    size_t o = 0;
+    for (size_t d=0; d<D; ++d) {
+      for (int p=0; p<P; ++p) {
+        size_t c = counts[p*D+d];
+        counts[p*D+d] = o; o += c;
+      }
+    }
+    #pragma omp parallel for schedule(static, 1) if(P>1)
+    for (int p=0; p<P; ++p) {
+      size_t i0 = N*p/P, i1 = N*(p+1)/P;
+      size_t *cp = &counts[p*D];
+      for (size_t i=i0; i<i1; ++i)
+        buf[cp[(fk(a[i]) >> s) & (D-1)]++] = a[i];
+    }
+    swap(a, buf);
+  }
+}
+
+
+
+
 // L1-NORM
 // -------
 
@@ -0,0 +1,140 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "_debug.hxx"
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+using std::vector;
+
+
+
+
+// PERF-COUNTS
+// -----------
+// Hardware performance counter readings.
+
+struct PerfCounts {
+  uint64_t cycles       = 0;
+  uint64_t instructions = 0;
+  uint64_t cacheMisses  = 0;  // last level cache
+  uint64_t branchMisses = 0;
+
+  inline PerfCounts& operator+=(const PerfCounts& x) noexcept {
+    cycles       += x.cycles;
+    instructions += x.instructions;
+    cacheMisses  += x.cacheMisses;
+    branchMisses += x.branchMisses;
+    return *this;
+  }
+
+  inline PerfCounts& operator/=(uint64_t n) noexcept {
+    cycles       /= n;
+    instructions /= n;
+    cacheMisses  /= n;
+    branchMisses /= n;
+    return *this;
+  }
+};
+
+
+inline void addPerfCountsAt(vector<PerfCounts>& a, size_t i, const PerfCounts& x) {
+  if (a.size()<=i) a.resize(i+1);
+  a[i] += x;
+}
+
+
+
+
+// PERF-COUNTERS
+// -------------
+// Hardware performance counters, with Linux perf_event_open().
+// Counters are opened as a group, so that they are scheduled together.
+// If they cannot be opened (unsupported, or not permitted), readings are zero.
+// Instrumentation is meant to be wrapped in PERFORMI(), so that it is only
+// compiled in with BUILD>=BUILD_INFO.
+
+class PerfCounters {
+  // Data.
+  protected:
+  static constexpr int N = 4;
+  int fd[N] = {-1, -1, -1, -1};
+
+
+  // Helpers.
+  protected:
+  #ifdef __linux__
+  inline int open(uint64_t config, int group) {
+    perf_event_attr pe;
+    memset(&pe, 0, sizeof(pe));
+    pe.type     = PERF_TYPE_HARDWARE;
+    pe.size     = sizeof(pe);
+    pe.config   = config;
+    pe.disabled = group<0? 1 : 0;
+    pe.exclude_kernel = 1;
+    pe.exclude_hv     = 1;
+    pe.read_format    = PERF_FORMAT_GROUP;
+    return int(syscall(__NR_perf_event_open, &pe, 0, -1, group, 0));
+  }
+  #endif
+
+
+  // Status operations.
+  public:
+  inline bool valid() const noexcept {
+    return fd[0]>=0;
+  }
+
+
+  // Measure operations.
+  public:
+  inline void start() noexcept {
+    #ifdef __linux__
+    if (!valid()) return;
+    ioctl(fd[0], PERF_EVENT_IOC_RESET,  PERF_IOC_FLAG_GROUP);
+    ioctl(fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    #endif
+  }
+
+  inline PerfCounts stop() noexcept {
+    PerfCounts a;
+    #ifdef __linux__
+    if (!valid()) return a;
+    ioctl(fd[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    uint64_t buf[1+N] = {};
+    if (read(fd[0], buf, sizeof(buf)) <= 0) return a;
+    uint64_t *x[N] = {&a.cycles, &a.instructions, &a.cacheMisses, &a.branchMisses};
+    for (int i=0, j=1; i<N && j<=int(buf[0]); ++i)
+      if (fd[i]>=0) *x[i] = buf[j++];
+    #endif
+    return a;
+  }
+
+
+  // Lifetime operations.
+  public:
+  PerfCounters() {
+    #ifdef __linux__
+    fd[0] = open(PERF_COUNT_HW_CPU_CYCLES, -1);
+    if (!valid()) return;
+    fd[1] = open(PERF_COUNT_HW_INSTRUCTIONS,   fd[0]);
+    fd[2] = open(PERF_COUNT_HW_CACHE_MISSES,   fd[0]);
+    fd[3] = open(PERF_COUNT_HW_BRANCH_MISSES,  fd[0]);
+    #endif
+  }
+
+  ~PerfCounters() {
+    #ifdef __linux__
+    for (int i=0; i<N; ++i)
+      if (fd[i]>=0) close(fd[i]);
+    #endif
+  }
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+};
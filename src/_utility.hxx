@@ -1,10 +1,18 @@
 #pragma once
+#include <cmath>
 #include <utility>
+#include <algorithm>
+#include <vector>
+#include <ratio>
 #include <chrono>
 #include "_debug.hxx"
 
 using std::pair;
-using std::chrono::microseconds;
+using std::vector;
+using std::sort;
+using std::sqrt;
+using std::milli;
+using std::chrono::duration;
 using std::chrono::high_resolution_clock;
 using std::chrono::duration_cast;
 
@@ -39,8 +47,8 @@ inline auto timeNow() {
 template <class T>
 float durationMilliseconds(const T& start, const T& stop) {
   ASSERT(stop >= start);
-  auto a = duration_cast<microseconds>(stop - start);
-  return a.count()/1000.0f;
+  auto a = duration_cast<duration<float, milli>>(stop - start);
+  return a.count();
 }
 
 
@@ -65,6 +73,55 @@ float measureDurationMarked(F fn, int N=1) {
 }
 
 
+/**
+ * Measure duration of marked portions of each run, after some warm-up runs.
+ * @param fn function to run, given a marker for portions to measure
+ * @param N number of measured runs
+ * @param W number of warm-up runs (not measured)
+ * @returns duration of each measured run (ms)
+ */
+template <class F>
+vector<float> measureDurationsMarked(F fn, int N=1, int W=0) {
+  ASSERT(N>0 && W>=0);
+  vector<float> a;
+  for (int i=0; i<W+N; i++) {
+    float duration = 0;
+    fn([&](auto fm) { duration += measureDuration(fm); });
+    if (i>=W) a.push_back(duration);
+  }
+  return a;
+}
+
+
+
+
+// DURATION-STATISTICS
+// -------------------
+
+struct DurationStatistics {
+  float min    = 0;
+  float median = 0;
+  float mean   = 0;
+  float stddev = 0;
+};
+
+
+inline DurationStatistics durationStatistics(vector<float> x) {
+  DurationStatistics a;
+  size_t N = x.size();
+  if (N==0) return a;
+  sort(x.begin(), x.end());
+  a.min    = x[0];
+  a.median = N&1? x[N/2] : (x[N/2-1] + x[N/2])/2;
+  for (float v : x)
+    a.mean += v/N;
+  for (float v : x)
+    a.stddev += (v-a.mean)*(v-a.mean)/N;
+  a.stddev = sqrt(a.stddev);
+  return a;
+}
+
+
 
 
 // RETRY
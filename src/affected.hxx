@@ -0,0 +1,138 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include "_main.hxx"
+
+using std::vector;
+using std::sort;
+using std::count;
+using std::unique;
+using std::binary_search;
+
+
+
+
+// AFFECTED-SET
+// ------------
+// Set of affected vertices of a batch update, with interchangeable backends.
+// A dense set keeps a flag per vertex, which costs a pass over the span to
+// clear and to iterate. A sparse set keeps a sorted list of vertices, so that
+// its cost scales with the number of affected vertices. A hybrid set starts
+// sparse, and becomes dense once it covers a given fraction of the span.
+//
+// Vertices added to a sparse set are pending until flush(), which is done
+// between iterations of local-moving. Vertices can be added concurrently.
+
+#define AFFECTED_DENSE  0
+#define AFFECTED_SPARSE 1
+#define AFFECTED_HYBRID 2
+
+
+template <class K>
+class AffectedSet {
+  // Data.
+  protected:
+  int    mode  = AFFECTED_DENSE;
+  double limit = 0.05;  // fraction of span above which a hybrid set becomes dense
+  K      S     = 0;
+  bool   dense = true;
+  vector<char> flags;    // dense: is vertex affected? (char, to be written concurrently)
+  vector<K>    keys;     // sparse: affected vertices, in ascending order
+  vector2d<K>  pending;  // sparse: vertices added since last flush, per thread
+
+
+  // Types.
+  public:
+  using key_type = K;
+
+
+  // Property operations.
+  public:
+  inline bool isDense() const noexcept { return dense; }
+  inline K    span()    const noexcept { return S; }
+  inline const vector<K>& sparseKeys() const noexcept { return keys; }
+
+  /** Bytes allocated by the set (flags, keys, and pending vertices). */
+  inline size_t bytes() const {
+    return vectorBytes(flags) + vectorBytes(keys) + vectorBytes(pending);
+  }
+
+  inline size_t size() const {
+    if (!dense) return keys.size();
+    return count(flags.begin(), flags.end(), 1);
+  }
+
+
+  // Access operations.
+  public:
+  inline bool has(K u) const {
+    return dense? flags[u]!=0 : binary_search(keys.begin(), keys.end(), u);
+  }
+  inline bool operator()(K u) const { return has(u); }
+
+  template <class F>
+  inline void forEach(F fn) const {
+    if (!dense) { for (K u : keys) fn(u); return; }
+    for (K u=0; u<S; ++u)
+      if (flags[u]) fn(u);
+  }
+
+
+  // Update operations.
+  public:
+  /**
+   * Clear the set, for vertices of a graph with given span.
+   * @param span span of graph
+   */
+  inline void reset(K span) {
+    S = span;
+    dense = mode==AFFECTED_DENSE;
+    keys.clear();
+    if (dense) flags.assign(S, 0);
+    else flags.clear();
+    pending.resize(ompMaxThreads());
+    for (auto& ks : pending) ks.clear();
+  }
+
+  inline void add(K u) {
+    if (dense) flags[u] = 1;
+    else pending[ompThreadNum()].push_back(u);
+  }
+
+  /**
+   * Make pending vertices visible, switching a hybrid set to dense if it has grown large.
+   */
+  inline void flush() {
+    if (dense) return;
+    mergePending();
+    if (mode==AFFECTED_HYBRID && keys.size() > limit*S) toDense();
+  }
+
+  inline void toDense() {
+    if (dense) return;
+    mergePending();
+    flags.assign(S, 0);
+    for (K u : keys) flags[u] = 1;
+    keys.clear();
+    dense = true;
+  }
+
+
+  protected:
+  inline void mergePending() {
+    size_t n = keys.size();
+    for (auto& ks : pending) {
+      keys.insert(keys.end(), ks.begin(), ks.end());
+      ks.clear();
+    }
+    if (keys.size()==n) return;
+    sort(keys.begin(), keys.end());
+    keys.erase(unique(keys.begin(), keys.end()), keys.end());
+  }
+
+
+  // Constructors.
+  public:
+  AffectedSet(int mode=AFFECTED_DENSE, double limit=0.05) :
+  mode(mode), limit(limit) {}
+};
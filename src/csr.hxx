@@ -1,13 +1,17 @@
 #pragma once
+#include <tuple>
 #include <numeric>
 #include <algorithm>
 #include <vector>
 #include "_main.hxx"
 
+using std::tuple;
 using std::vector;
+using std::get;
 using std::iota;
 using std::equal;
 using std::transform;
+using std::sort;
 
 
 
@@ -160,6 +164,52 @@ void csrGraphW(G& a, const vector<K>& xv, const vector<K>& xe) {
   csrGraphW(a, xv.data(), _, xe.data(), _);
 }
 
+/**
+ * Add edges of a graph in CSR format, with rows added in parallel.
+ * @param a output graph, with all source and target vertices (updated)
+ * @param xv offset of each vertex's edges
+ * @param xd degree of each vertex (optional)
+ * @param xe target vertex of each edge
+ * @param xw weight of each edge (optional)
+ * @param N number of vertices (rows)
+ */
+template <class G, class K, class V>
+void csrAddEdgesOmpW(G& a, const K *xv, const K *xd, const K *xe, const V *xw, size_t N) {
+  // Only the thread adding a row touches out-edges of its vertex.
+  #pragma omp parallel for schedule(dynamic, 2048)
+  for (size_t u=0; u<N; ++u) {
+    K OFF = xv[u];
+    K DEG = xd? xd[u] : xv[u+1] - xv[u];
+    for (K j=K(); j<DEG; ++j) {
+      K v = xe[OFF+j];
+      V w = xw? xw[OFF+j] : V(1);
+      a.addEdgeOmp(K(u), v, w);
+    }
+  }
+  a.correctOmp();
+}
+
+
+template <class G, class K, class V>
+void csrGraphOmpW(G& a, const K *xv, const K *xd, const K *xe, const V *xw, size_t N) {
+  for (size_t u=0; u<N; ++u)
+    a.addVertex(u);
+  csrAddEdgesOmpW(a, xv, xd, xe, xw, N);
+}
+template <class G, class K, class V>
+void csrGraphOmpW(G& a, const vector<K>& xv, const vector<K>& xd, const vector<K>& xe, const vector<V>& xw) {
+  const K *_xd = xd.empty()? nullptr : xd.data();
+  const V *_xw = xw.empty()? nullptr : xw.data();
+  csrGraphOmpW(a, xv.data(), _xd, xe.data(), _xw, xv.size()-1);
+}
+
+template <class K, class V>
+auto csrGraphOmp(const vector<K>& xv, const vector<K>& xd, const vector<K>& xe, const vector<V>& xw) {
+  OutDiGraph<K, None, V> a; csrGraphOmpW(a, xv, xd, xe, xw);
+  return a;
+}
+
+
 template <class G, class K, class V>
 auto csrGraph(const K *xv, const K *xd, const K *xe, const V *xw, size_t N) {
   OutDiGraph<K, None, V> a; csrGraphW(a, xv, xd, xe, xw, N);
@@ -179,6 +229,88 @@ auto csrGraph(const vector<K>& xv, const vector<K>& xe) {
 
 
 
+// CSR-FROM-EDGES
+// --------------
+// Build CSR arrays from a list of edges, in parallel. Edges are counted per
+// source vertex, offsets are found with a parallel exclusive scan, and edge
+// ids are scattered into their rows. Each row is then sorted by target vertex
+// (and edge id, so that the result does not depend on scatter order), and
+// edges to the same target vertex are merged.
+
+/**
+ * Build CSR arrays from a list of edges.
+ * @param xv offset of each vertex's edges (output, S+1 entries)
+ * @param xe target vertex of each edge (output)
+ * @param xw weight of each edge (output)
+ * @param es edges (source, target, weight)
+ * @param S span of vertex ids (all ids are less than this)
+ * @param sym add reverse of each edge?
+ * @param fm merge weights of duplicate edges (earlier, later)
+ */
+template <class K, class V, class FM>
+void csrFromEdgesOmpW(vector<K>& xv, vector<K>& xe, vector<V>& xw, const vector<tuple<K, K, V>>& es, K S, bool sym, FM fm) {
+  size_t N = es.size(), NE = sym? 2*N : N;
+  // Entry j is edge j/2 (reversed if j is odd) if symmetric, else edge j.
+  auto fu = [&](size_t j) { return sym? ((j&1)? get<1>(es[j>>1]) : get<0>(es[j>>1])) : get<0>(es[j]); };
+  auto fv = [&](size_t j) { return sym? ((j&1)? get<0>(es[j>>1]) : get<1>(es[j>>1])) : get<1>(es[j]); };
+  auto fw = [&](size_t j) { return sym? get<2>(es[j>>1]) : get<2>(es[j]); };
+  vector<size_t> counts(S+1), offsets(S+1), ids(NE);
+  vector<V> ws(NE);
+  // Count, and scatter entries into rows.
+  #pragma omp parallel for schedule(auto)
+  for (size_t j=0; j<NE; ++j) {
+    K u = fu(j);
+    #pragma omp atomic
+    ++counts[u];
+  }
+  exclusiveScanOmp(counts, offsets);
+  copyValuesOmp(offsets, counts);
+  #pragma omp parallel for schedule(auto)
+  for (size_t j=0; j<NE; ++j) {
+    K u = fu(j); size_t i;
+    #pragma omp atomic capture
+    i = counts[u]++;
+    ids[i] = j;
+  }
+  // Sort and merge each row.
+  #pragma omp parallel for schedule(dynamic, 2048)
+  for (K u=0; u<S; ++u) {
+    size_t i0 = offsets[u], i1 = offsets[u+1], k = i0;
+    sort(ids.begin()+i0, ids.begin()+i1, [&](size_t i, size_t j) {
+      K vi = fv(i), vj = fv(j);
+      return vi<vj || (vi==vj && i<j);
+    });
+    for (size_t i=i0; i<i1; ++i) {
+      size_t j = ids[i];
+      if (k>i0 && fv(ids[k-1])==fv(j)) { ws[k-1] = fm(ws[k-1], fw(j)); continue; }
+      ids[k] = j; ws[k] = fw(j); ++k;
+    }
+    counts[u] = k - i0;
+  }
+  counts[S] = 0;
+  // Compact rows into CSR arrays.
+  xv.resize(S+1);
+  exclusiveScanOmp(counts, xv);
+  xe.resize(xv[S]);
+  xw.resize(xv[S]);
+  #pragma omp parallel for schedule(dynamic, 2048)
+  for (K u=0; u<S; ++u) {
+    for (size_t i=0; i<counts[u]; ++i) {
+      xe[xv[u]+i] = fv(ids[offsets[u]+i]);
+      xw[xv[u]+i] = ws[offsets[u]+i];
+    }
+  }
+}
+template <class K, class V>
+inline void csrFromEdgesOmpW(vector<K>& xv, vector<K>& xe, vector<V>& xw, const vector<tuple<K, K, V>>& es, K S, bool sym=false) {
+  // The later of duplicate edges is kept, as with addEdge().
+  auto fm = [](auto, auto b) { return b; };
+  csrFromEdgesOmpW(xv, xe, xw, es, S, sym, fm);
+}
+
+
+
+
 // CSR-SUM-EDGE-VALUES
 // -------------------
 
@@ -40,3 +40,28 @@ inline auto duplicate(const G& x) {
   G a; duplicateW(a, x, true);
   return a;
 }
+
+
+
+/**
+ * Duplicate a graph, with out-edges of each vertex added in parallel.
+ * Edges are added (first-touched) by the thread that processes their source
+ * vertex in a statically scheduled loop over vertices.
+ * @param a output graph, with only out-edges (updated, should be empty)
+ * @param x original graph
+ */
+template <class H, class G>
+void duplicateOmpW(H& a, const G& x) {
+  using K = typename G::key_type;
+  K S = x.span();
+  x.forEachVertex([&](auto u, auto d) { a.addVertex(u, d); });
+  #pragma omp parallel for schedule(static)
+  for (K u=0; u<S; ++u)
+    x.forEachEdge(u, [&](auto v, auto w) { a.addEdgeOmp(u, v, w); });
+  a.correctOmp(true);
+}
+template <class G>
+inline auto duplicateOmp(const G& x) {
+  G a; duplicateOmpW(a, x);
+  return a;
+}
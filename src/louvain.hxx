@@ -2,18 +2,102 @@
 #include <utility>
 #include <algorithm>
 #include <vector>
+#include <atomic>
+#include <functional>
 #include "_main.hxx"
 #include "Graph.hxx"
 #include "duplicate.hxx"
+#include "update.hxx"
+#include "affected.hxx"
 #include "modularity.hxx"
 
 using std::pair;
 using std::tuple;
+using std::atomic;
+using std::function;
 using std::vector;
 using std::make_pair;
+using std::tie;
 using std::move;
 using std::get;
 using std::min;
+using std::max;
+
+
+
+
+// LOUVAIN-BUDGET
+// --------------
+// Bound the time taken by a run, for a latency target. A run stops early once
+// its time budget is spent, or once it is cancelled from another thread, and
+// then returns communities found so far (flattened through completed passes).
+// Local-moving checks this every so many vertices, and no further pass is
+// started (or aggregated graph built) after it.
+
+/** Cancellation token, shared with the caller. */
+class LouvainCancel {
+  atomic<bool> flag;
+
+  public:
+  inline void cancel() noexcept { flag.store(true, std::memory_order_relaxed); }
+  inline void reset()  noexcept { flag.store(false, std::memory_order_relaxed); }
+  inline bool cancelled() const noexcept { return flag.load(std::memory_order_relaxed); }
+  LouvainCancel() : flag(false) {}
+};
+
+
+/** Progress of a run, after each local-moving iteration. */
+struct LouvainProgress {
+  int    pass;       // current pass (from 0)
+  int    iteration;  // iteration in current pass (from 0)
+  double change;     // total delta-modularity of moves in iteration
+  float  elapsed;    // time since start of run (ms)
+};
+
+
+/** Time budget and progress reporting of a single run. */
+class LouvainBudget {
+  using clock_type = decltype(timeNow());
+  static constexpr size_t INTERVAL = 1024;  // vertices between checks of clock
+  clock_type start;
+  float budget;          // in ms (0: none)
+  const LouvainCancel* cancel;
+  const function<void(const LouvainProgress&)>* progress;
+  atomic<bool> stop;
+  int pass = 0;
+
+  public:
+  /** Has run been stopped? */
+  inline bool stopped() const noexcept { return stop.load(std::memory_order_relaxed); }
+
+  /**
+   * Check if run should stop, looking at the clock only every so often.
+   * @param i index of vertex being processed (clock is checked for multiples of interval)
+   */
+  inline bool expired(size_t i) {
+    if (stopped()) return true;
+    if (i % INTERVAL) return false;
+    return expired();
+  }
+  inline bool expired() {
+    if (stopped()) return true;
+    bool a = (cancel && cancel->cancelled()) || (budget>0 && elapsed() >= budget);
+    if (a) stop.store(true, std::memory_order_relaxed);
+    return a;
+  }
+
+  inline float elapsed() const { return durationMilliseconds(start, timeNow()); }
+  inline void  setPass(int p) noexcept { pass = p; }
+
+  /** Report progress after an iteration of local-moving. */
+  template <class V>
+  inline void iterated(int l, V el) {
+    if (progress && *progress) (*progress)({pass, l, double(el), elapsed()});
+  }
+
+  LouvainBudget(float budget=0, const LouvainCancel* cancel=nullptr, const function<void(const LouvainProgress&)>* progress=nullptr) :
+  start(timeNow()), budget(budget), cancel(cancel), progress(progress), stop(false) {}
+};
 
 
 
@@ -21,6 +105,26 @@ using std::min;
 // LOUVAIN-OPTIONS
 // ---------------
 
+// Conflict mitigation in parallel local-moving, where neighbors that move at
+// the same time see stale communities (and may keep swapping communities).
+#define LOUVAIN_CONFLICT_NONE      0
+#define LOUVAIN_CONFLICT_SINGLETON 1  // a singleton only joins a singleton of lower id
+#define LOUVAIN_CONFLICT_COLOR     2  // vertices of one color at a time (no two are neighbors; no chunks or sparse visits)
+
+
+// Limits on estimated affected fraction of a batch, for choosing a technique.
+// They are non-decreasing, and strictly increasing below 1 so that each
+// technique (and static, beyond the last limit) can be chosen.
+struct LouvainAutoLimits {
+  double frontier;        // use frontier upto this estimated affected fraction
+  double deltaScreening;  // else, use delta-screening upto this fraction
+  double naiveDynamic;    // else, use naive-dynamic upto this fraction (static beyond)
+
+  LouvainAutoLimits(double frontier=0.2, double deltaScreening=0.4, double naiveDynamic=0.8) :
+  frontier(frontier), deltaScreening(deltaScreening), naiveDynamic(naiveDynamic) {}
+};
+
+
 template <class T>
 struct LouvainOptions {
   int repeat;
@@ -30,9 +134,19 @@ struct LouvainOptions {
   T   tolerenceDeclineFactor;
   int maxIterations;
   int maxPasses;
-
-  LouvainOptions(int repeat=1, T resolution=1, T tolerance=1e-2, T passTolerance=0, T tolerenceDeclineFactor=10, int maxIterations=500, int maxPasses=500) :
-  repeat(repeat), resolution(resolution), tolerance(tolerance), passTolerance(passTolerance), tolerenceDeclineFactor(tolerenceDeclineFactor), maxIterations(maxIterations), maxPasses(maxPasses) {}
+  int warmup;
+  int numa;  // NUMA policy of buffers (parallel Louvain)
+  bool   balance;    // split vertices into degree-balanced chunks (parallel Louvain)
+  size_t hubDegree;  // degree of vertices scanned by all threads together (parallel Louvain, 0: none)
+  int    conflict;   // conflict mitigation policy (parallel Louvain)
+  int    affected;   // backend of affected vertex sets (dynamic Louvain)
+  LouvainAutoLimits autoLimits;  // for choosing a technique per batch (dynamic Louvain)
+  float timeBudget;       // stop a run after so long, in ms (0: none)
+  LouvainCancel* cancel;  // stop a run once cancelled (optional)
+  function<void(const LouvainProgress&)> progress;  // called after each local-moving iteration (optional)
+
+  LouvainOptions(int repeat=1, T resolution=1, T tolerance=1e-2, T passTolerance=0, T tolerenceDeclineFactor=10, int maxIterations=500, int maxPasses=500, int warmup=0, int numa=NUMA_DEFAULT, bool balance=false, size_t hubDegree=0, int conflict=LOUVAIN_CONFLICT_NONE, int affected=AFFECTED_DENSE, LouvainAutoLimits autoLimits={}, float timeBudget=0, LouvainCancel* cancel=nullptr, function<void(const LouvainProgress&)> progress=nullptr) :
+  repeat(repeat), resolution(resolution), tolerance(tolerance), passTolerance(passTolerance), tolerenceDeclineFactor(tolerenceDeclineFactor), maxIterations(maxIterations), maxPasses(maxPasses), warmup(warmup), numa(numa), balance(balance), hubDegree(hubDegree), conflict(conflict), affected(affected), autoLimits(autoLimits), timeBudget(timeBudget), cancel(cancel), progress(progress) {}
 };
 
 
@@ -47,6 +161,30 @@ struct LouvainResult {
   int   iterations;
   int   passes;
   float time;
+  float minTime    = 0;
+  float medianTime = 0;
+  float stddevTime = 0;
+  size_t affectedVertices  = 0;
+  int    technique = -1;          // chosen for batch, if automatic (LOUVAIN_TECHNIQUE_*)
+  double estimatedAffected = NAN; // estimated affected fraction of batch, if automatic
+  bool   truncated = false;       // stopped early by time budget or cancellation?
+  size_t graphBytes     = 0;  // allocated by working copy of input graph
+  size_t aggregateBytes = 0;  // allocated by largest aggregated graph (of passes, or maintained)
+  size_t workspaceBytes = 0;  // allocated by workspace (size-S vectors, scan buffers)
+  size_t affectedBytes  = 0;  // allocated by affected set (if any)
+  float initializationTime = 0;
+  float markingTime        = 0;
+  float localMoveTime      = 0;
+  float aggregationTime    = 0;
+  float lookupTime         = 0;
+  vector<float> passTime;
+  vector<int>   passIterations;
+  vector<K>     passVertices;
+  vector<float> threadBusyTime;  // of each thread, in local-moving and aggregation (parallel)
+  vector<PerfCounts> passInitializationCounts;
+  vector<PerfCounts> passLocalMoveCounts;
+  vector<PerfCounts> passAggregationCounts;
+  vector<PerfCounts> passLookupCounts;
 
   LouvainResult(vector<K>&& membership, int iterations=0, int passes=0, float time=0) :
   membership(membership), iterations(iterations), passes(passes), time(time) {}
@@ -58,6 +196,109 @@ struct LouvainResult {
 
 
 
+// LOUVAIN-WORKSPACE
+// -----------------
+// Buffers reused across calls (such as successive batch updates).
+// They grow geometrically with the span of the graph, so that a slowly
+// growing graph does not cause a reallocation on every batch.
+
+template <class K, class V>
+struct LouvainWorkspace {
+  vector<K> vcom, vcs, a, cmap, csiz;
+  vector<K> coff, cmem;  // vertices of each community (delta-screening)
+  vector<V> vtot, ctot, vcout;
+  vector2d<K> vcsp;    // per thread
+  vector2d<V> vcoutp;  // per thread
+};
+
+
+/**
+ * Find the bytes allocated by a workspace.
+ * @param w workspace
+ * @returns bytes allocated
+ */
+template <class K, class V>
+size_t louvainWorkspaceBytes(const LouvainWorkspace<K, V>& w) {
+  size_t a = vectorBytes(w.vcom) + vectorBytes(w.vcs) + vectorBytes(w.a) + vectorBytes(w.cmap) + vectorBytes(w.csiz);
+  a += vectorBytes(w.coff) + vectorBytes(w.cmem);
+  a += vectorBytes(w.vtot) + vectorBytes(w.ctot) + vectorBytes(w.vcout);
+  a += vectorBytes(w.vcsp) + vectorBytes(w.vcoutp);
+  return a;
+}
+
+
+template <class T>
+bool louvainGrowBuffer(vector<T>& x, size_t N) {
+  bool grow = x.capacity() < N;
+  if (grow) x.reserve(max(N, 2*x.capacity()));
+  x.resize(N);
+  return grow;
+}
+
+
+/**
+ * Place a (newly allocated) buffer as per NUMA policy, zeroing it.
+ * Pages are released and then touched again in a statically scheduled loop,
+ * so that each is placed on the node of the thread processing it.
+ * @param x buffer (updated)
+ * @param numa NUMA policy (NUMA_DEFAULT, NUMA_FIRST_TOUCH, NUMA_INTERLEAVE)
+ */
+template <class T>
+void louvainPlaceBufferOmp(vector<T>& x, int numa) {
+  size_t N = x.size();
+  if (numa==NUMA_DEFAULT) return;
+  if (numa==NUMA_INTERLEAVE) numaInterleavePages(x.data(), N*sizeof(T));
+  numaReleasePages(x.data(), N*sizeof(T));
+  #pragma omp parallel for schedule(static)
+  for (size_t i=0; i<N; ++i)
+    x[i] = T();
+}
+
+template <class K, class V>
+void louvainGrowWorkspace(LouvainWorkspace<K, V>& w, size_t N) {
+  louvainGrowBuffer(w.vcom,  N);
+  louvainGrowBuffer(w.a,     N);
+  louvainGrowBuffer(w.cmap,  N);
+  louvainGrowBuffer(w.vtot,  N);
+  louvainGrowBuffer(w.ctot,  N);
+  louvainGrowBuffer(w.vcout, N);
+}
+
+/**
+ * Grow workspace for parallel Louvain, placing newly allocated buffers as per NUMA policy.
+ * @param w workspace (updated)
+ * @param N span of graph
+ * @param numa NUMA policy (NUMA_DEFAULT, NUMA_FIRST_TOUCH, NUMA_INTERLEAVE)
+ */
+template <class K, class V>
+void louvainGrowWorkspaceOmp(LouvainWorkspace<K, V>& w, size_t N, int numa=NUMA_DEFAULT) {
+  size_t T = ompMaxThreads();
+  if (louvainGrowBuffer(w.vcom, N)) louvainPlaceBufferOmp(w.vcom, numa);
+  if (louvainGrowBuffer(w.a,    N)) louvainPlaceBufferOmp(w.a,    numa);
+  if (louvainGrowBuffer(w.cmap, N)) louvainPlaceBufferOmp(w.cmap, numa);
+  if (louvainGrowBuffer(w.vtot, N)) louvainPlaceBufferOmp(w.vtot, numa);
+  if (louvainGrowBuffer(w.ctot, N)) louvainPlaceBufferOmp(w.ctot, numa);
+  if (louvainGrowBuffer(w.csiz, N)) louvainPlaceBufferOmp(w.csiz, numa);
+  if (w.vcsp.size()   < T) w.vcsp.resize(T);
+  if (w.vcoutp.size() < T) w.vcoutp.resize(T);
+  // Scan buffers of a thread are placed on its own node.
+  #pragma omp parallel
+  {
+    auto& vcout = w.vcoutp[ompThreadNum()];
+    size_t B = N*sizeof(V);
+    if (louvainGrowBuffer(vcout, N) && numa!=NUMA_DEFAULT) {
+      if (numa==NUMA_INTERLEAVE) numaInterleavePages(vcout.data(), B);
+      numaReleasePages(vcout.data(), B);
+      fillValueU(vcout, V());
+    }
+  }
+  for (size_t t=0; t<T; ++t)
+    louvainGrowBuffer(w.vcoutp[t], N);
+}
+
+
+
+
 // LOUVAIN-INITIALIZE
 // ------------------
 
@@ -76,6 +317,18 @@ void louvainVertexWeights(vector<V>& vtot, const G& x) {
 }
 
 
+template <class G, class V>
+void louvainVertexWeightsOmp(vector<V>& vtot, const G& x) {
+  using K = typename G::key_type;
+  K S = x.span();
+  #pragma omp parallel for schedule(runtime)
+  for (K u=0; u<S; ++u) {
+    if (!x.hasVertex(u)) continue;
+    x.forEachEdge(u, [&](auto v, auto w) { vtot[u] += w; });
+  }
+}
+
+
 /**
  * Find the total edge weight of each community.
  * @param ctot total edge weight of each community (updated, should be initialized to 0)
@@ -92,6 +345,38 @@ void louvainCommunityWeights(vector<V>& ctot, const G& x, const vector<K>& vcom,
 }
 
 
+template <class G, class K, class V>
+void louvainCommunityWeightsOmp(vector<V>& ctot, const G& x, const vector<K>& vcom, const vector<V>& vtot) {
+  K S = x.span();
+  #pragma omp parallel for schedule(static)
+  for (K u=0; u<S; ++u) {
+    if (!x.hasVertex(u)) continue;
+    K c = vcom[u];
+    #pragma omp atomic
+    ctot[c] += vtot[u];
+  }
+}
+
+
+/**
+ * Find the number of vertices in each community.
+ * @param csiz number of vertices in each community (updated, should be initialized to 0)
+ * @param x original graph
+ * @param vcom community each vertex belongs to
+ */
+template <class G, class K>
+void louvainCommunitySizesOmp(vector<K>& csiz, const G& x, const vector<K>& vcom) {
+  K S = x.span();
+  #pragma omp parallel for schedule(static)
+  for (K u=0; u<S; ++u) {
+    if (!x.hasVertex(u)) continue;
+    K c = vcom[u];
+    #pragma omp atomic
+    ++csiz[c];
+  }
+}
+
+
 /**
  * Initialize communities such that each vertex is its own community.
  * @param vcom community each vertex belongs to (updated, should be initialized to 0)
@@ -107,9 +392,22 @@ void louvainInitialize(vector<K>& vcom, vector<V>& ctot, const G& x, const vecto
   });
 }
 
+template <class G, class K, class V>
+void louvainInitializeOmp(vector<K>& vcom, vector<V>& ctot, const G& x, const vector<V>& vtot) {
+  K S = x.span();
+  #pragma omp parallel for schedule(static)
+  for (K u=0; u<S; ++u) {
+    if (!x.hasVertex(u)) continue;
+    vcom[u] = u;
+    ctot[u] = vtot[u];
+  }
+}
+
 
 /**
  * Initialize communities from given initial communities.
+ * Vertices without a (valid) initial community start in their own community,
+ * and vertices no longer in the graph do not contribute to community weights.
  * @param vcom community each vertex belongs to (updated, should be initialized to 0)
  * @param ctot total edge weight of each community (updated, should be initilized to 0)
  * @param x original graph
@@ -118,10 +416,44 @@ void louvainInitialize(vector<K>& vcom, vector<V>& ctot, const G& x, const vecto
  */
 template <class G, class K, class V>
 void louvainInitializeFrom(vector<K>& vcom, vector<V>& ctot, const G& x, const vector<V>& vtot, const vector<K>& q) {
-  copyValues(q, vcom, 0, min(q.size(), vcom.size()));
+  K S = x.span();
+  x.forEachVertexKey([&](auto u) {
+    bool has = size_t(u) < q.size() && q[u] < S;
+    vcom[u]  = has? q[u] : u;
+  });
   louvainCommunityWeights(ctot, x, vcom, vtot);
 }
 
+template <class G, class K, class V>
+void louvainInitializeFromOmp(vector<K>& vcom, vector<V>& ctot, const G& x, const vector<V>& vtot, const vector<K>& q) {
+  K S = x.span();
+  #pragma omp parallel for schedule(static)
+  for (K u=0; u<S; ++u) {
+    if (!x.hasVertex(u)) continue;
+    bool has = size_t(u) < q.size() && q[u] < S;
+    vcom[u]  = has? q[u] : u;
+  }
+  louvainCommunityWeightsOmp(ctot, x, vcom, vtot);
+}
+
+
+/**
+ * Obtain initial communities for a graph, whose vertices may have changed.
+ * @param x original graph
+ * @param q initial community each vertex belongs to (of an earlier graph)
+ * @returns initial communities, with new vertices in their own community
+ */
+template <class G, class K>
+auto louvainCommunitiesFrom(const G& x, const vector<K>& q) {
+  K S = x.span();
+  vector<K> a(S);
+  for (K u=0; u<S; ++u) {
+    bool has = size_t(u) < q.size() && q[u] < S;
+    a[u] = has? q[u] : u;
+  }
+  return a;
+}
+
 
 
 
@@ -216,6 +548,163 @@ void louvainChangeCommunity(vector<K>& vcom, vector<V>& ctot, const G& x, K u, K
   vcom[u] = c;
 }
 
+template <class G, class K, class V>
+void louvainChangeCommunityOmp(vector<K>& vcom, vector<V>& ctot, const G&, K u, K c, const vector<V>& vtot) {
+  K d = vcom[u];
+  #pragma omp atomic
+  ctot[d] -= vtot[u];
+  #pragma omp atomic
+  ctot[c] += vtot[u];
+  vcom[u] = c;
+}
+
+template <class G, class K, class V>
+void louvainChangeCommunityOmp(vector<K>& vcom, vector<V>& ctot, vector<K>& csiz, const G& x, K u, K c, const vector<V>& vtot) {
+  K d = vcom[u];
+  #pragma omp atomic
+  --csiz[d];
+  #pragma omp atomic
+  ++csiz[c];
+  louvainChangeCommunityOmp(vcom, ctot, x, u, c, vtot);
+}
+
+
+
+
+// LOUVAIN-PARTITION
+// -----------------
+// Split of vertices among threads, for skewed degree distributions.
+// Vertices are split into contiguous chunks of about equal work (degree + 1),
+// which are handed out to threads dynamically. Vertices of very high degree
+// (hubs) are left out of chunks, and scanned by all threads together.
+
+template <class K>
+struct LouvainPartition {
+  vector<K> chunks;  // chunk boundaries (first is 0, last is span), or empty
+  vector<K> hubs;    // vertices scanned by all threads together
+  size_t hubDegree = 0;  // minimum degree of a hub (0: no hubs)
+  vector<K> colorVertices;  // vertices ordered by color (for conflict mitigation)
+  vector<K> colorOffsets;   // offset of each color in colorVertices, or empty
+};
+
+
+/**
+ * Split items into contiguous chunks of about equal work.
+ * @param chunks chunk boundaries (output)
+ * @param S number of items
+ * @param n number of chunks
+ * @param fw work of an item (u)
+ */
+template <class K, class FW>
+void louvainWorkChunks(vector<K>& chunks, K S, size_t n, FW fw) {
+  vector<size_t> offsets(S+1);
+  for (K u=0; u<S; ++u)
+    offsets[u+1] = offsets[u] + fw(u);
+  size_t W = offsets[S];
+  chunks.clear();
+  chunks.push_back(0);
+  for (size_t i=1; i<n; ++i) {
+    K b = K(lower_bound(offsets.begin(), offsets.end(), W*i/n) - offsets.begin());
+    if (b>chunks.back() && b<S) chunks.push_back(b);
+  }
+  if (S>0) chunks.push_back(S);
+}
+
+
+/**
+ * Split vertices among threads, as per work of scanning their edges.
+ * @param pt vertex partition (output)
+ * @param x original graph
+ * @param n number of chunks (0 to leave vertices unchunked)
+ * @param H minimum degree of a hub (0 for no hubs)
+ */
+template <class G, class K>
+void louvainPartitionOmp(LouvainPartition<K>& pt, const G& x, size_t n, size_t H) {
+  K S = x.span();
+  pt.hubDegree = H;
+  pt.hubs.clear();
+  pt.chunks.clear();
+  if (H) x.forEachVertexKey([&](auto u) { if (size_t(x.degree(u))>=H) pt.hubs.push_back(u); });
+  if (n==0) return;
+  louvainWorkChunks(pt.chunks, S, n, [&](auto u) {
+    size_t D = x.hasVertex(u)? x.degree(u) : 0;
+    return !x.hasVertex(u) || (H && D>=H)? size_t() : D+1;
+  });
+}
+
+
+
+
+// LOUVAIN-COLOR
+// -------------
+// Distance-1 coloring of vertices, with speculative greedy coloring in parallel.
+// Each vertex takes the smallest color not used by its neighbors, and then
+// vertices with a smaller neighbor of the same color are colored again.
+
+/**
+ * Color vertices such that no two neighbors have the same color.
+ * @param vcol color of each vertex, from 1 (output)
+ * @param forbp forbidden colors, per thread (temporary buffers, updated)
+ * @param x original graph
+ * @returns number of colors
+ */
+template <class G, class K>
+K louvainColorVerticesOmp(vector<K>& vcol, vector2d<K>& forbp, const G& x) {
+  K S = x.span();
+  vector<K> us, vs;
+  vcol.assign(S, K());
+  x.forEachVertexKey([&](auto u) { us.push_back(u); });
+  while (!us.empty()) {
+    size_t N = us.size();
+    #pragma omp parallel for schedule(runtime)
+    for (size_t i=0; i<N; ++i) {
+      K u = us[i];
+      auto& forb = forbp[ompThreadNum()];
+      if (forb.size() < size_t(x.degree(u))+2) forb.resize(x.degree(u)+2);
+      x.forEachEdgeKey(u, [&](auto v) { if (size_t(vcol[v]) < forb.size()) forb[vcol[v]] = u+1; });
+      K c = 1;
+      while (forb[c]==u+1) ++c;
+      vcol[u] = c;
+    }
+    vector<char> redo(N);
+    #pragma omp parallel for schedule(runtime)
+    for (size_t i=0; i<N; ++i) {
+      K u = us[i];
+      x.forEachEdgeKey(u, [&](auto v) { if (v<u && vcol[v]==vcol[u]) redo[i] = true; });
+    }
+    vs.clear();
+    for (size_t i=0; i<N; ++i)
+      if (redo[i]) vs.push_back(us[i]);
+    swap(us, vs);
+  }
+  K C = 0;
+  x.forEachVertexKey([&](auto u) { C = max(C, vcol[u]); });
+  return C;
+}
+
+
+/**
+ * Group vertices by color, for conflict mitigation in local-moving.
+ * @param pt vertex partition (updated)
+ * @param vcol color of each vertex (temporary buffer, updated)
+ * @param forbp forbidden colors, per thread (temporary buffers, updated)
+ * @param x original graph
+ */
+template <class G, class K>
+void louvainPartitionColorsOmp(LouvainPartition<K>& pt, vector<K>& vcol, vector2d<K>& forbp, const G& x) {
+  K C = louvainColorVerticesOmp(vcol, forbp, x);
+  auto& offsets = pt.colorOffsets;
+  offsets.assign(C+2, K());
+  x.forEachVertexKey([&](auto u) { ++offsets[vcol[u]+1]; });
+  for (K c=1; c<=C+1; ++c)
+    offsets[c] += offsets[c-1];
+  pt.colorVertices.resize(offsets[C+1]);
+  x.forEachVertexKey([&](auto u) { pt.colorVertices[offsets[vcol[u]]++] = u; });
+  for (K c=C+1; c>0; --c)
+    offsets[c] = offsets[c-1];
+  offsets[0] = 0;
+}
+
 
 
 
@@ -236,23 +725,67 @@ void louvainChangeCommunity(vector<K>& vcom, vector<V>& ctot, const G& x, K u, K
  * @param L max iterations
  * @param fa is a vertex affected?
  * @param fp process vertices whose communities have changed
+ * @param bg time budget of run (optional)
  * @returns iterations performed
  */
 template <class G, class K, class V, class FA, class FP>
-int louvainMove(vector<K>& vcom, vector<V>& ctot, vector<K>& vcs, vector<V>& vcout, const G& x, const vector<V>& vtot, V M, V R, V E, int L, FA fa, FP fp) {
+int louvainMove(vector<K>& vcom, vector<V>& ctot, vector<K>& vcs, vector<V>& vcout, const G& x, const vector<V>& vtot, V M, V R, V E, int L, FA fa, FP fp, LouvainBudget* bg=nullptr) {
   K S = x.span();
   int l = 0; V Q = V();
   for (; l<L;) {
     V el = V();
     x.forEachVertexKey([&](auto u) {
+      if (bg && bg->expired(u)) return;
       if (!fa(u)) return;
       louvainClearScan(vcs, vcout);
       louvainScanCommunities(vcs, vcout, x, u, vcom);
       auto [c, e] = louvainChooseCommunity(x, u, vcom, vtot, ctot, vcs, vcout, M, R);
-      if (c)      { louvainChangeCommunity(vcom, ctot, x, u, c, vtot); fp(u); }
+      if (e>V())  { louvainChangeCommunity(vcom, ctot, x, u, c, vtot); fp(u); }
       el += e;  // l1-norm
     }); ++l;
-    if (el<=E) break;
+    if (bg) bg->iterated(l-1, el);
+    if (el<=E || (bg && bg->expired())) break;
+  }
+  return l;
+}
+
+/**
+ * Louvain algorithm's local moving phase, over a set of affected vertices.
+ * Only vertices in the set are visited, and vertices added to a sparse set
+ * are visited from the next iteration.
+ * @param vcom community each vertex belongs to (initial, updated)
+ * @param ctot total edge weight of each community (precalculated, updated)
+ * @param vcs communities vertex u is linked to (temporary buffer, updated)
+ * @param vcout total edge weight from vertex u to community C (temporary buffer, updated)
+ * @param x original graph
+ * @param vtot total edge weight of each vertex
+ * @param M total weight of "undirected" graph (1/2 of directed graph)
+ * @param R resolution (0, 1]
+ * @param E tolerance
+ * @param L max iterations
+ * @param aff affected vertices (updated, flushed after each iteration)
+ * @param fp process vertices whose communities have changed
+ * @param bg time budget of run (optional)
+ * @returns iterations performed
+ */
+template <class G, class K, class V, class FP>
+int louvainMove(vector<K>& vcom, vector<V>& ctot, vector<K>& vcs, vector<V>& vcout, const G& x, const vector<V>& vtot, V M, V R, V E, int L, AffectedSet<K>& aff, FP fp, LouvainBudget* bg=nullptr) {
+  int l = 0;
+  for (; l<L;) {
+    V el = V();
+    size_t i = 0;
+    aff.forEach([&](auto u) {
+      if (bg && bg->expired(i++)) return;
+      if (!x.hasVertex(u)) return;
+      louvainClearScan(vcs, vcout);
+      louvainScanCommunities(vcs, vcout, x, u, vcom);
+      auto [c, e] = louvainChooseCommunity(x, u, vcom, vtot, ctot, vcs, vcout, M, R);
+      if (e>V())  { louvainChangeCommunity(vcom, ctot, x, u, c, vtot); fp(u); }
+      el += e;  // l1-norm
+    }); ++l;
+    aff.flush();
+    if (bg) bg->iterated(l-1, el);
+    if (el<=E || (bg && bg->expired())) break;
   }
   return l;
 }
@@ -268,6 +801,211 @@ inline int louvainMove(vector<K>& vcom, vector<V>& ctot, vector<K>& vcs, vector<
 }
 
 
+/**
+ * Choose connected community with best delta modularity, for a hub vertex.
+ * Edges of the hub are scanned by all threads, into their own buffers, which
+ * are then merged into those of thread 0.
+ * @param vcsp communities vertex u is linked to, per thread (temporary buffers, updated)
+ * @param vcoutp total edge weight from vertex u to community C, per thread (temporary buffers, updated)
+ * @param busy busy time of each thread in ms (updated)
+ * @param x original graph
+ * @param u given vertex
+ * @param vcom community each vertex belongs to
+ * @param vtot total edge weight of each vertex
+ * @param ctot total edge weight of each community
+ * @param M total weight of "undirected" graph (1/2 of directed graph)
+ * @param R resolution (0, 1]
+ * @returns [best community, delta modularity]
+ */
+template <class G, class K, class V>
+auto louvainChooseCommunityHubOmp(vector2d<K>& vcsp, vector2d<V>& vcoutp, vector<float>& busy, const G& x, K u, const vector<K>& vcom, const vector<V>& vtot, const vector<V>& ctot, V M, V R) {
+  size_t T = vcsp.size();
+  auto es  = x.cedges(u);
+  size_t D = es.size();
+  for (size_t t=0; t<T; ++t)
+    louvainClearScan(vcsp[t], vcoutp[t]);
+  #pragma omp parallel
+  {
+    int  t  = ompThreadNum();
+    auto t0 = timeNow();
+    #pragma omp for schedule(static) nowait
+    for (size_t i=0; i<D; ++i) {
+      const auto& [v, w] = *(es.begin() + i);
+      louvainScanCommunity(vcsp[t], vcoutp[t], u, v, w, vcom);
+    }
+    busy[t] += durationMilliseconds(t0, timeNow());
+  }
+  auto& vcs = vcsp[0]; auto& vcout = vcoutp[0];
+  for (size_t t=1; t<T; ++t) {
+    for (K c : vcsp[t]) {
+      if (!vcout[c]) vcs.push_back(c);
+      vcout[c] += vcoutp[t][c];
+    }
+    louvainClearScan(vcsp[t], vcoutp[t]);
+  }
+  return louvainChooseCommunity(x, u, vcom, vtot, ctot, vcs, vcout, M, R);
+}
+
+
+/**
+ * Louvain algorithm's local moving phase, with vertices processed in parallel.
+ * Each thread scans communities into its own buffers (vcsp[t], vcoutp[t]),
+ * and community weights are updated atomically. Community ids of neighbors
+ * may be stale while they are being read, as is usual for parallel Louvain.
+ * Without chunks, vertices are scheduled as per omp_set_schedule(); hubs are
+ * processed after all other vertices, one at a time. With colors, vertices of
+ * one color are processed at a time, so that no two neighbors move together
+ * (chunks and sparse affected vertices are then not used). With community
+ * sizes, a singleton vertex only joins a singleton community of lower id, so
+ * that two singleton neighbors do not swap communities.
+ * @param vcom community each vertex belongs to (initial, updated)
+ * @param ctot total edge weight of each community (precalculated, updated)
+ * @param csiz number of vertices in each community (precalculated, updated, optional)
+ * @param vcsp communities vertex u is linked to, per thread (temporary buffers, updated)
+ * @param vcoutp total edge weight from vertex u to community C, per thread (temporary buffers, updated)
+ * @param busy busy time of each thread in ms (updated)
+ * @param x original graph
+ * @param pt partition of vertices among threads
+ * @param vtot total edge weight of each vertex
+ * @param M total weight of "undirected" graph (1/2 of directed graph)
+ * @param R resolution (0, 1]
+ * @param E tolerance
+ * @param L max iterations
+ * @param fa is a vertex affected? (called concurrently)
+ * @param fp process vertices whose communities have changed (called concurrently)
+ * @param aff affected vertices, visited directly if sparse (updated, flushed after each iteration, optional)
+ * @param bg time budget of run (optional)
+ * @returns iterations performed
+ */
+template <class G, class K, class V, class FA, class FP>
+int louvainMoveOmp(vector<K>& vcom, vector<V>& ctot, vector<K>* csiz, vector2d<K>& vcsp, vector2d<V>& vcoutp, vector<float>& busy, const G& x, const LouvainPartition<K>& pt, const vector<V>& vtot, V M, V R, V E, int L, FA fa, FP fp, AffectedSet<K>* aff=nullptr, LouvainBudget* bg=nullptr) {
+  K S = x.span();
+  size_t H = pt.hubDegree;
+  size_t C = pt.chunks.size();
+  size_t N = pt.colorOffsets.size();
+  int l = 0;
+  auto fc = [&](K u, K c) {
+    if (csiz) louvainChangeCommunityOmp(vcom, ctot, *csiz, x, u, c, vtot);
+    else      louvainChangeCommunityOmp(vcom, ctot, x, u, c, vtot);
+  };
+  // Clock is checked every so many vertices of a loop (i), by the thread there.
+  auto fu = [&](K u, int t, size_t i) {
+    if (bg && bg->expired(i)) return V();
+    if (!x.hasVertex(u) || !fa(u)) return V();
+    if (H && size_t(x.degree(u))>=H) return V();
+    auto& vcs = vcsp[t]; auto& vcout = vcoutp[t];
+    louvainClearScan(vcs, vcout);
+    louvainScanCommunities(vcs, vcout, x, u, vcom);
+    auto [c, e] = louvainChooseCommunity(x, u, vcom, vtot, ctot, vcs, vcout, M, R);
+    if (csiz && c>vcom[u] && (*csiz)[c]==1 && (*csiz)[vcom[u]]==1) return V();
+    if (e>V())  { fc(u, c); fp(u); }
+    return e;
+  };
+  for (; l<L;) {
+    V el = V();
+    #pragma omp parallel reduction(+:el)
+    {
+      int  t  = ompThreadNum();
+      auto t0 = timeNow();
+      if (N>0) {
+        // Wait for each color at a barrier, which is not counted as busy time.
+        for (size_t k=0; k+1<N; ++k) {
+          #pragma omp for schedule(runtime) nowait
+          for (K i=pt.colorOffsets[k]; i<pt.colorOffsets[k+1]; ++i)
+            el += fu(pt.colorVertices[i], t, i);
+          busy[t] += durationMilliseconds(t0, timeNow());
+          #pragma omp barrier
+          t0 = timeNow();
+        }
+      }
+      else if (aff && !aff->isDense()) {
+        const auto& ks = aff->sparseKeys();
+        #pragma omp for schedule(runtime) nowait
+        for (size_t i=0; i<ks.size(); ++i)
+          el += fu(ks[i], t, i);
+      }
+      else if (C==0) {
+        #pragma omp for schedule(runtime) nowait
+        for (K u=0; u<S; ++u)
+          el += fu(u, t, u);  // l1-norm
+      }
+      else {
+        #pragma omp for schedule(dynamic, 1) nowait
+        for (size_t i=0; i<C-1; ++i) {
+          for (K u=pt.chunks[i]; u<pt.chunks[i+1]; ++u)
+            el += fu(u, t, u);
+        }
+      }
+      busy[t] += durationMilliseconds(t0, timeNow());
+    }
+    for (K u : pt.hubs) {
+      if (bg && bg->expired()) break;
+      if (!fa(u)) continue;
+      auto [c, e] = louvainChooseCommunityHubOmp(vcsp, vcoutp, busy, x, u, vcom, vtot, ctot, M, R);
+      if (e>V())  { fc(u, c); fp(u); }
+      el += e;
+    } ++l;
+    if (aff) aff->flush();
+    if (bg) bg->iterated(l-1, el);
+    if (el<=E || (bg && bg->expired())) break;
+  }
+  return l;
+}
+template <class G, class K, class V, class FP>
+inline int louvainMoveOmp(vector<K>& vcom, vector<V>& ctot, vector<K>* csiz, vector2d<K>& vcsp, vector2d<V>& vcoutp, vector<float>& busy, const G& x, const LouvainPartition<K>& pt, const vector<V>& vtot, V M, V R, V E, int L, AffectedSet<K>& aff, FP fp, LouvainBudget* bg=nullptr) {
+  auto fa = [&](auto u) { return aff.has(u); };
+  return louvainMoveOmp(vcom, ctot, csiz, vcsp, vcoutp, busy, x, pt, vtot, M, R, E, L, fa, fp, &aff, bg);
+}
+template <class G, class K, class V, class FA>
+inline int louvainMoveOmp(vector<K>& vcom, vector<V>& ctot, vector<K>* csiz, vector2d<K>& vcsp, vector2d<V>& vcoutp, vector<float>& busy, const G& x, const LouvainPartition<K>& pt, const vector<V>& vtot, V M, V R, V E, int L, FA fa) {
+  auto fp = [](auto u) {};
+  return louvainMoveOmp(vcom, ctot, csiz, vcsp, vcoutp, busy, x, pt, vtot, M, R, E, L, fa, fp);
+}
+template <class G, class K, class V>
+inline int louvainMoveOmp(vector<K>& vcom, vector<V>& ctot, vector<K>* csiz, vector2d<K>& vcsp, vector2d<V>& vcoutp, vector<float>& busy, const G& x, const LouvainPartition<K>& pt, const vector<V>& vtot, V M, V R, V E, int L) {
+  auto fa = [](auto u) { return true; };
+  return louvainMoveOmp(vcom, ctot, csiz, vcsp, vcoutp, busy, x, pt, vtot, M, R, E, L, fa);
+}
+
+
+
+
+// LOUVAIN-RENUMBER-COMMUNITIES
+// ----------------------------
+// Map community ids to dense ids [0, C), in the order of old ids.
+// This keeps the span of aggregated graphs (and per-community buffers of
+// later passes) equal to the number of communities, not vertices.
+
+/**
+ * Renumber communities to dense ids.
+ * @param vcom community each vertex belongs to (updated)
+ * @param cmap new id of each old community (temporary buffer, updated)
+ * @param x original graph
+ * @returns number of communities C
+ */
+template <class G, class K>
+K louvainRenumberCommunities(vector<K>& vcom, vector<K>& cmap, const G& x) {
+  K S = x.span();
+  fillValueU(cmap, 0, S, K());
+  #pragma omp parallel for schedule(static)
+  for (K u=0; u<S; ++u) {
+    if (!x.hasVertex(u)) continue;
+    #pragma omp atomic write
+    cmap[vcom[u]] = K(1);
+  }
+  K C = 0;
+  for (K c=0; c<S; ++c) {
+    K f = cmap[c];
+    cmap[c] = C;
+    C += f;
+  }
+  #pragma omp parallel for schedule(static)
+  for (K u=0; u<S; ++u)
+    if (x.hasVertex(u)) vcom[u] = cmap[vcom[u]];
+  return C;
+}
+
+
 
 
 // LOUVAIN-AGGREGATE
@@ -282,6 +1020,26 @@ auto louvainCommunityVertices(const G& x, const vector<K>& vcom) {
 }
 
 
+/**
+ * Find the vertices of each community, one community after another (reusing buffers).
+ * @param coff offset of vertices of each community in cmem (output, span+1)
+ * @param cmem vertices of each community, in order of community id (output)
+ * @param x original graph
+ * @param vcom community each vertex belongs to
+ */
+template <class G, class K>
+void louvainCommunityVerticesW(vector<K>& coff, vector<K>& cmem, const G& x, const vector<K>& vcom) {
+  K S = x.span();
+  coff.assign(S+1, K());
+  x.forEachVertexKey([&](auto u) { ++coff[vcom[u]+1]; });
+  for (K c=0; c<S; ++c) coff[c+1] += coff[c];
+  cmem.resize(coff[S]);
+  x.forEachVertexKey([&](auto u) { cmem[coff[vcom[u]]++] = u; });
+  for (K c=S; c>0; --c) coff[c] = coff[c-1];
+  coff[0] = K();
+}
+
+
 /**
  * Louvain algorithm's community aggregation phase.
  * @param a output graph
@@ -310,6 +1068,162 @@ inline auto louvainAggregate(vector<K>& vcs, vector<V>& vcout, const G& x, const
   G a; louvainAggregate(a, vcs, vcout, x, vcom);
   return a;
 }
+template <class G, class K>
+inline auto louvainAggregate(const G& x, const vector<K>& vcom) {
+  using V = typename G::edge_value_type;
+  vector<K> vcs; vector<V> vcout(x.span());
+  return louvainAggregate(vcs, vcout, x, vcom);
+}
+
+
+/**
+ * Louvain algorithm's community aggregation phase, with communities scanned in parallel.
+ * Super-vertices are added first, and then super-edges of each community are
+ * added by the thread that scans it.
+ * @param a output graph
+ * @param vcsp communities vertex u is linked to, per thread (temporary buffers, updated)
+ * @param vcoutp total edge weight from vertex u to community C, per thread (temporary buffers, updated)
+ * @param busy busy time of each thread in ms (updated)
+ * @param x original graph
+ * @param vcom community each vertex belongs to
+ * @param n number of chunks of communities, balanced by edges (0 to use dynamic schedule)
+ */
+template <class G, class K, class V>
+void louvainAggregateOmp(G& a, vector2d<K>& vcsp, vector2d<V>& vcoutp, vector<float>& busy, const G& x, const vector<K>& vcom, size_t n=0) {
+  K S = x.span();
+  auto comv = louvainCommunityVertices(x, vcom);
+  vector<K> chunks;
+  if (n) louvainWorkChunks(chunks, S, n, [&](auto c) {
+    size_t w = 0;
+    for (K u : comv[c]) w += x.degree(u) + 1;
+    return w;
+  });
+  for (K c=0; c<S; ++c)
+    if (!comv[c].empty()) a.addVertex(c);
+  auto fc = [&](K c, int t) {
+    if (comv[c].empty()) return;
+    auto& vcs = vcsp[t]; auto& vcout = vcoutp[t];
+    louvainClearScan(vcs, vcout);
+    for (K u : comv[c])
+      louvainScanCommunities<true>(vcs, vcout, x, u, vcom);
+    for (auto d : vcs)
+      a.addEdgeOmp(c, d, vcout[d]);
+  };
+  size_t C = chunks.size();
+  #pragma omp parallel
+  {
+    int  t  = ompThreadNum();
+    auto t0 = timeNow();
+    if (C==0) {
+      #pragma omp for schedule(dynamic, 64) nowait
+      for (K c=0; c<S; ++c)
+        fc(c, t);
+    }
+    else {
+      #pragma omp for schedule(dynamic, 1) nowait
+      for (size_t i=0; i<C-1; ++i) {
+        for (K c=chunks[i]; c<chunks[i+1]; ++c)
+          fc(c, t);
+      }
+    }
+    busy[t] += durationMilliseconds(t0, timeNow());
+  }
+  a.correctOmp(true);
+}
+template <class G, class K, class V>
+inline auto louvainAggregateOmp(vector2d<K>& vcsp, vector2d<V>& vcoutp, vector<float>& busy, const G& x, const vector<K>& vcom, size_t n=0) {
+  G a; louvainAggregateOmp(a, vcsp, vcoutp, busy, x, vcom, n);
+  return a;
+}
+
+
+
+
+// LOUVAIN-AGGREGATE-DYNAMIC
+// -------------------------
+// Maintain aggregated graph across batch updates.
+// - Edge insertions, deletions, and weight changes are applied as weight deltas on super-edges `(vcom[u], vcom[v])`.
+// - Vertices that change community move their edge weight between super-vertices.
+// - Super-vertices of emptied communities are left behind without any edges.
+
+/**
+ * Add weight to a super-edge, removing it if its weight drops to zero.
+ * @param a aggregated graph (updated)
+ * @param c source super-vertex
+ * @param d target super-vertex
+ * @param w weight to add (negative to remove)
+ */
+template <class G, class K, class V>
+void louvainAggregateAddWeight(G& a, K c, K d, V w) {
+  V e = a.edgeValue(c, d) + w;
+  if (e<=V()) a.removeEdge(c, d);
+  else if (!a.setEdgeValue(c, d, e)) a.addEdge(c, d, e);
+}
+
+
+/**
+ * Update aggregated graph with a batch of edge deletions and insertions.
+ * @param a aggregated graph, with communities as super-vertices (updated)
+ * @param deletions edge deletions for this batch update (undirected, with deleted weight)
+ * @param insertions edge insertions for this batch update (undirected)
+ * @param vcom community each vertex belongs to (same as used for aggregation)
+ */
+template <class G, class K, class V>
+void louvainAggregateEdgesW(G& a, const vector<tuple<K, K, V>>& deletions, const vector<tuple<K, K, V>>& insertions, const vector<K>& vcom) {
+  // Insertions go first, so that super-edge weights never drop below zero midway.
+  for (const auto& [u, v, w] : insertions)
+    louvainAggregateAddWeight(a, vcom[u], vcom[v],  w);
+  for (const auto& [u, v, w] : deletions)
+    louvainAggregateAddWeight(a, vcom[u], vcom[v], -w);
+  a.correct();
+}
+
+
+/**
+ * Update aggregated graph with a batch of edge weight updates.
+ * @param a aggregated graph, with communities as super-vertices (updated)
+ * @param updates edge weight deltas for this batch update (undirected, negative for decrease/deletion)
+ * @param vcom community each vertex belongs to (same as used for aggregation)
+ */
+template <class G, class K, class V>
+void louvainAggregateEdgesW(G& a, const vector<tuple<K, K, V>>& updates, const vector<K>& vcom) {
+  // Increases go first, so that super-edge weights never drop below zero midway.
+  for (const auto& [u, v, w] : updates)
+    if (w>V()) louvainAggregateAddWeight(a, vcom[u], vcom[v], w);
+  for (const auto& [u, v, w] : updates)
+    if (w<V()) louvainAggregateAddWeight(a, vcom[u], vcom[v], w);
+  a.correct();
+}
+template <class G, class K, class V>
+inline void louvainAggregateEdgesW(G& a, const EdgeBatch<K, V>& batch, const vector<K>& vcom) {
+  louvainAggregateEdgesW(a, batch.edges, vcom);
+}
+
+
+/**
+ * Move edge weight of vertices that changed community between super-vertices.
+ * @param a aggregated graph, as per old communities (updated)
+ * @param x original graph
+ * @param vcom0 old community each vertex belongs to
+ * @param vcom1 new community each vertex belongs to
+ */
+template <class H, class G, class K>
+void louvainAggregateMovesW(H& a, const G& x, const vector<K>& vcom0, const vector<K>& vcom1) {
+  x.forEachVertexKey([&](auto u) {
+    K c0 = vcom0[u], c1 = vcom1[u];
+    if (c0==c1) return;
+    x.forEachEdge(u, [&](auto v, auto w) {
+      K d0 = vcom0[v], d1 = vcom1[v];
+      louvainAggregateAddWeight(a, c0, d0, -w);
+      louvainAggregateAddWeight(a, c1, d1,  w);
+      // Reverse edge of an unmoved neighbor is not visited otherwise.
+      if (d0!=d1) return;
+      louvainAggregateAddWeight(a, d0, c0, -w);
+      louvainAggregateAddWeight(a, d1, c1,  w);
+    });
+  });
+  a.correct();
+}
 
 
 
@@ -328,6 +1242,14 @@ void louvainLookupCommunities(vector<K>& a, const vector<K>& vcom) {
     v = vcom[v];
 }
 
+template <class K>
+void louvainLookupCommunitiesOmp(vector<K>& a, const vector<K>& vcom) {
+  size_t N = a.size();
+  #pragma omp parallel for schedule(static)
+  for (size_t i=0; i<N; ++i)
+    a[i] = vcom[a[i]];
+}
+
 
 
 
@@ -339,48 +1261,92 @@ void louvainLookupCommunities(vector<K>& a, const vector<K>& vcom) {
 //   `i`'s neighbors and `j*`'s community is marked as affected.
 // - For edge deletions within the same community `i` and `j`,
 //   `i`'s neighbors and `j`'s community is marked as affected.
+// - Edge weight increases are screened as insertions, and decreases as deletions.
 
 /**
- * Find the vertices which should be processed upon a batch of edge insertions and deletions.
+ * Mark the vertices which should be processed upon a batch of edge weight updates.
+ * Neighbors and communities to expand are kept in sparse sets, whatever the
+ * backend of the affected set. Vertices of marked communities are visited
+ * through lists of community members, built with a counting pass (without a
+ * lookup per vertex) only when a community is marked.
+ * @param a affected vertices (output)
+ * @param vcs communities vertex u is linked to (temporary buffer, updated)
+ * @param vcout total edge weight from vertex u to community C (temporary buffer, updated)
+ * @param coff offset of vertices of each community in cmem (temporary buffer, updated)
+ * @param cmem vertices of each community, in order of community id (temporary buffer, updated)
  * @param x original graph
- * @param deletions edge deletions for this batch update (undirected, sorted by source vertex id)
- * @param insertions edge insertions for this batch update (undirected, sorted by source vertex id)
+ * @param batch edge weight deltas for this batch update (undirected, grouped by source vertex, negative for decrease/deletion)
  * @param vcom community each vertex belongs to
  * @param vtot total edge weight of each vertex
  * @param ctot total edge weight of each community
  * @param M total weight of "undirected" graph (1/2 of directed graph)
  * @param R resolution (0, 1]
- * @returns flags for each vertex marking whether it is affected
  */
 template <class G, class K, class V>
-auto louvainAffectedVerticesDeltaScreening(const G& x, const vector<tuple<K, K>>& deletions, const vector<tuple<K, K, V>>& insertions, const vector<K>& vcom, const vector<V>& vtot, const vector<V>& ctot, V M, V R=V(1)) {
-  K S = x.span();
-  vector<K> vcs; vector<V> vcout(S);
-  vector<bool> vertices(S), neighbors(S), communities(S);
-  for (const auto& [u, v] : deletions) {
-    if (vcom[u] != vcom[v]) continue;
-    vertices[u]  = true;
-    neighbors[u] = true;
-    communities[vcom[v]] = true;
-  }
-  for (size_t i=0; i<insertions.size();) {
-    K u = get<0>(insertions[i]);
+void louvainAffectedVerticesDeltaScreeningW(AffectedSet<K>& a, vector<K>& vcs, vector<V>& vcout, vector<K>& coff, vector<K>& cmem, const G& x, const EdgeBatch<K, V>& batch, const vector<K>& vcom, const vector<V>& vtot, const vector<V>& ctot, V M, V R=V(1)) {
+  AffectedSet<K> neighbors(AFFECTED_SPARSE), communities(AFFECTED_SPARSE);
+  a.reset(x.span());
+  neighbors.reset(x.span());
+  communities.reset(x.span());
+  bool expand = false;
+  for (size_t g=0; g<batch.sources.size(); ++g) {
+    K u = batch.sources[g];
+    bool increased = false;
     louvainClearScan(vcs, vcout);
-    for (; i<insertions.size() && get<0>(insertions[i])==u; ++i) {
-      K v = get<1>(insertions[i]);
-      V w = get<2>(insertions[i]);
-      if (vcom[u] == vcom[v]) continue;
-      louvainScanCommunity(vcs, vcout, u, v, w, vcom);
+    for (size_t i=batch.offsets[g]; i<batch.offsets[g+1]; ++i) {
+      K v = get<1>(batch.edges[i]);
+      V w = get<2>(batch.edges[i]);
+      // Decrease within community (as deletion).
+      if (w<V() && vcom[u]==vcom[v]) {
+        a.add(u);
+        neighbors.add(u);
+        communities.add(vcom[v]);
+        expand = true;
+      }
+      // Increase across communities (as insertion).
+      if (w>V()) increased = true;
+      if (w>V() && vcom[u]!=vcom[v]) louvainScanCommunity(vcs, vcout, u, v, w, vcom);
     }
+    if (!increased) continue;
     auto [c, e] = louvainChooseCommunity(x, u, vcom, vtot, ctot, vcs, vcout, M, R);
-    vertices[u]  = true;
-    neighbors[u] = true;
-    communities[c] = true;
+    a.add(u);
+    neighbors.add(u);
+    // Without a gain, c is only the default (community 0).
+    if (e>V()) { communities.add(c); expand = true; }
   }
-  x.forEachVertexKey([&](auto u) {
-    if (neighbors[u]) x.forEachEdgeKey(u, [&](auto v) { vertices[v] = true; });
-    if (communities[vcom[u]]) vertices[u] = true;
-  });
+  louvainClearScan(vcs, vcout);
+  neighbors.flush();
+  communities.flush();
+  neighbors.forEach([&](auto u) { x.forEachEdgeKey(u, [&](auto v) { a.add(v); }); });
+  if (expand) {
+    louvainCommunityVerticesW(coff, cmem, x, vcom);
+    communities.forEach([&](auto c) {
+      for (K i=coff[c]; i<coff[c+1]; ++i) a.add(cmem[i]);
+    });
+  }
+  a.flush();
+}
+
+
+/**
+ * Find the vertices which should be processed upon a batch of edge insertions and deletions.
+ * @param x original graph
+ * @param deletions edge deletions for this batch update (undirected, sorted by source vertex id, with deleted weight)
+ * @param insertions edge insertions for this batch update (undirected, sorted by source vertex id)
+ * @param vcom community each vertex belongs to
+ * @param vtot total edge weight of each vertex
+ * @param ctot total edge weight of each community
+ * @param M total weight of "undirected" graph (1/2 of directed graph)
+ * @param R resolution (0, 1]
+ * @returns flags for each vertex marking whether it is affected
+ */
+template <class G, class K, class V>
+inline auto louvainAffectedVerticesDeltaScreening(const G& x, const vector<tuple<K, K, V>>& deletions, const vector<tuple<K, K, V>>& insertions, const vector<K>& vcom, const vector<V>& vtot, const vector<V>& ctot, V M, V R=V(1)) {
+  K S = x.span();
+  AffectedSet<K> a; vector<K> vcs, coff, cmem; vector<V> vcout(S);
+  vector<bool> vertices(S);
+  louvainAffectedVerticesDeltaScreeningW(a, vcs, vcout, coff, cmem, x, edgeBatchOmp(edgeUpdates(deletions, insertions), S), vcom, vtot, ctot, M, R);
+  a.forEach([&](auto u) { vertices[u] = true; });
   return vertices;
 }
 
@@ -395,27 +1361,418 @@ auto louvainAffectedVerticesDeltaScreening(const G& x, const vector<tuple<K, K>>
 //   `i` is marked as affected.
 // - For edge deletions within the same community `i` and `j`,
 //   `i` is marked as affected.
+// - Edge weight increases are treated as insertions, and decreases as deletions.
 // - Vertices whose communities change in local-moving phase have their neighbors marked as affected.
 
+/**
+ * Mark the vertices which should be processed upon a batch of edge weight updates.
+ * @param a affected vertices (output)
+ * @param x original graph
+ * @param batch edge weight deltas for this batch update (undirected, grouped by source vertex, negative for decrease/deletion)
+ * @param vcom community each vertex belongs to
+ */
+template <class G, class K, class V>
+void louvainAffectedVerticesFrontierW(AffectedSet<K>& a, const G& x, const EdgeBatch<K, V>& batch, const vector<K>& vcom) {
+  a.reset(x.span());
+  for (size_t g=0; g<batch.sources.size(); ++g) {
+    K u = batch.sources[g];
+    for (size_t i=batch.offsets[g]; i<batch.offsets[g+1]; ++i) {
+      K v = get<1>(batch.edges[i]);
+      V w = get<2>(batch.edges[i]);
+      if (w<V() && vcom[u] != vcom[v]) continue;
+      if (w>V() && vcom[u] == vcom[v]) continue;
+      a.add(u);
+      break;
+    }
+  }
+  a.flush();
+}
+
+
 /**
  * Find the vertices which should be processed upon a batch of edge insertions and deletions.
  * @param x original graph
- * @param deletions edge deletions for this batch update (undirected, sorted by source vertex id)
+ * @param deletions edge deletions for this batch update (undirected, sorted by source vertex id, with deleted weight)
  * @param insertions edge insertions for this batch update (undirected, sorted by source vertex id)
  * @param vcom community each vertex belongs to
  * @returns flags for each vertex marking whether it is affected
  */
 template <class G, class K, class V>
-auto louvainAffectedVerticesFrontier(const G& x, const vector<tuple<K, K>>& deletions, const vector<tuple<K, K, V>>& insertions, const vector<K>& vcom) {
+inline auto louvainAffectedVerticesFrontier(const G& x, const vector<tuple<K, K, V>>& deletions, const vector<tuple<K, K, V>>& insertions, const vector<K>& vcom) {
   K S = x.span();
+  AffectedSet<K> a;
   vector<bool> vertices(S);
-  for (const auto& [u, v] : deletions) {
-    if (vcom[u] != vcom[v]) continue;
-    vertices[u]  = true;
+  louvainAffectedVerticesFrontierW(a, x, edgeBatchOmp(edgeUpdates(deletions, insertions), S), vcom);
+  a.forEach([&](auto u) { vertices[u] = true; });
+  return vertices;
+}
+
+
+
+
+// LOUVAIN-AFFECTED-VERTICES-DELTA-FRONTIER
+// ----------------------------------------
+// Using delta-screening to seed the frontier approach.
+// - Sources are picked as with the frontier approach, and each is screened
+//   with its best delta-modularity move (over all its edges, after the update).
+// - For edge additions across communities with source vertex `i`, `i` is marked
+//   as affected only if it gains by moving to some community `c*`.
+// - For edge deletions within the same community, `i` is always marked as affected.
+// - Neighbors of `i` in `c*` (the boundary of `c*` next to `i`) are also marked.
+// - Vertices whose communities change in local-moving phase have their neighbors marked as affected.
+
+/**
+ * Mark the vertices which should be processed first upon a batch of edge weight updates.
+ * @param a affected vertices (output)
+ * @param vcs communities vertex u is linked to (temporary buffer, updated)
+ * @param vcout total edge weight from vertex u to community C (temporary buffer, updated)
+ * @param x updated graph
+ * @param batch edge weight deltas for this batch update (undirected, grouped by source vertex, negative for decrease/deletion)
+ * @param vcom community each vertex belongs to
+ * @param vtot total edge weight of each vertex
+ * @param ctot total edge weight of each community
+ * @param M total weight of "undirected" graph (1/2 of directed graph)
+ * @param R resolution (0, 1]
+ */
+template <class G, class K, class V>
+void louvainAffectedVerticesDeltaFrontierW(AffectedSet<K>& a, vector<K>& vcs, vector<V>& vcout, const G& x, const EdgeBatch<K, V>& batch, const vector<K>& vcom, const vector<V>& vtot, const vector<V>& ctot, V M, V R=V(1)) {
+  a.reset(x.span());
+  for (size_t g=0; g<batch.sources.size(); ++g) {
+    K u = batch.sources[g];
+    bool deleted = false, inserted = false;
+    for (size_t i=batch.offsets[g]; i<batch.offsets[g+1]; ++i) {
+      K v = get<1>(batch.edges[i]);
+      V w = get<2>(batch.edges[i]);
+      if (w<V() && vcom[u]==vcom[v]) deleted  = true;
+      if (w>V() && vcom[u]!=vcom[v]) inserted = true;
+    }
+    if (!deleted && !inserted) continue;
+    louvainClearScan(vcs, vcout);
+    louvainScanCommunities(vcs, vcout, x, u, vcom);
+    auto [c, e] = louvainChooseCommunity(x, u, vcom, vtot, ctot, vcs, vcout, M, R);
+    if (deleted || e>V()) a.add(u);
+    if (e<=V()) continue;
+    x.forEachEdgeKey(u, [&](auto v) { if (vcom[v]==c) a.add(v); });
   }
-  for (const auto& [u, v, w] : insertions) {
-    if (vcom[u] == vcom[v]) continue;
-    vertices[u]  = true;
+  louvainClearScan(vcs, vcout);
+  a.flush();
+}
+
+
+
+
+// LOUVAIN-DYNAMIC-AUTO
+// --------------------
+// Choose a technique for a batch update, from an estimate of the fraction of
+// vertices it affects. The estimate is the fraction of vertices that would be
+// initially marked by the frontier approach, which takes time linear in the
+// size of the batch (the affected set then grows as vertices move). The limits
+// on this fraction can be calibrated from benchmark results, with the estimate
+// reported by each dynamic technique.
+
+#define LOUVAIN_TECHNIQUE_STATIC          0
+#define LOUVAIN_TECHNIQUE_NAIVE_DYNAMIC   1
+#define LOUVAIN_TECHNIQUE_DELTA_SCREENING 2
+#define LOUVAIN_TECHNIQUE_FRONTIER        3
+
+
+inline const char* louvainTechniqueName(int t) {
+  switch (t) {
+    case LOUVAIN_TECHNIQUE_STATIC:          return "static";
+    case LOUVAIN_TECHNIQUE_NAIVE_DYNAMIC:   return "naive-dynamic";
+    case LOUVAIN_TECHNIQUE_DELTA_SCREENING: return "delta-screening";
+    case LOUVAIN_TECHNIQUE_FRONTIER:        return "frontier";
+    default: return "";
   }
-  return vertices;
+}
+
+
+/**
+ * Estimate the fraction of vertices affected by a batch of edge weight updates.
+ * @param x updated graph
+ * @param batch edge weight deltas for this batch update (undirected, grouped by source vertex, negative for decrease/deletion)
+ * @param q community each vertex belongs to (new vertices, beyond its size, are in their own community)
+ * @returns estimated affected fraction [0, 1]
+ */
+template <class G, class K, class V>
+double louvainEstimateAffectedFraction(const G& x, const EdgeBatch<K, V>& batch, const vector<K>& q) {
+  K S = x.span();
+  size_t a = 0;
+  auto fc = [&](K u) { return size_t(u)<q.size()? q[u] : K(q.size()) + u; };
+  for (size_t g=0; g<batch.sources.size(); ++g) {
+    K u = batch.sources[g];
+    for (size_t i=batch.offsets[g]; i<batch.offsets[g+1]; ++i) {
+      K v = get<1>(batch.edges[i]);
+      V w = get<2>(batch.edges[i]);
+      if (w<V() && fc(u) != fc(v)) continue;
+      if (w>V() && fc(u) == fc(v)) continue;
+      ++a;
+      break;
+    }
+  }
+  return S>0? min(double(a) / S, 1.0) : 0;
+}
+
+
+/**
+ * Choose a technique for a batch update.
+ * @param f estimated affected fraction
+ * @param l limits on affected fraction of each technique
+ * @param previous are communities before the update known?
+ * @returns technique (LOUVAIN_TECHNIQUE_*)
+ */
+inline int louvainAutoTechnique(double f, const LouvainAutoLimits& l, bool previous=true) {
+  if (!previous)            return LOUVAIN_TECHNIQUE_STATIC;
+  if (f<=l.frontier)        return LOUVAIN_TECHNIQUE_FRONTIER;
+  if (f<=l.deltaScreening)  return LOUVAIN_TECHNIQUE_DELTA_SCREENING;
+  if (f<=l.naiveDynamic)    return LOUVAIN_TECHNIQUE_NAIVE_DYNAMIC;
+  return LOUVAIN_TECHNIQUE_STATIC;
+}
+
+
+
+
+// LOUVAIN-RESULT-ASSEMBLE
+// -----------------------
+// Shared by sequential and parallel Louvain, once all runs are done.
+
+/**
+ * Give vertices not in the graph unused community ids (to start alone upon arrival).
+ * @param a community each vertex belongs to (updated)
+ * @param x original graph
+ */
+template <class G, class K>
+void louvainAbsentCommunitiesW(vector<K>& a, const G& x) {
+  K S = x.span();
+  vector<bool> used(S); vector<K> absent;
+  x.forEachVertexKey([&](auto u) { used[a[u]] = true; });
+  for (K u=0; u<S; ++u) {
+    if (x.hasVertex(u)) continue;
+    if (used[u]) absent.push_back(u);
+    else { a[u] = u; used[u] = true; }
+  }
+  K c = 0;
+  for (K u : absent) {
+    while (used[c]) ++c;
+    a[u] = c; used[c] = true;
+  }
+}
+
+
+/**
+ * Assemble the result of Louvain, with phase timings averaged over runs.
+ * @param x original graph
+ * @param a community each vertex belongs to (copied)
+ * @param l iterations performed
+ * @param p passes performed
+ * @param ts duration of each run
+ * @param o louvain options
+ * @param ti total initialization time
+ * @param tm total marking time
+ * @param tl total local-moving time
+ * @param ta total aggregation time
+ * @param tk total lookup time
+ * @param tp total time of each pass
+ * @param lp iterations of each pass
+ * @param np vertices of each pass
+ * @returns louvain result
+ */
+template <class G, class K, class V>
+inline auto louvainResultFrom(const G& x, const vector<K>& a, int l, int p, const vector<float>& ts, const LouvainOptions<V>& o, float ti, float tm, float tl, float ta, float tk, const vector<float>& tp, const vector<int>& lp, const vector<K>& np) {
+  auto st = durationStatistics(ts);
+  LouvainResult<K> r(vector<K>(a), l, p, st.mean);  // copy, keeping workspace buffer
+  r.minTime    = st.min;
+  r.medianTime = st.median;
+  r.stddevTime = st.stddev;
+  r.affectedVertices   = x.order();
+  r.initializationTime = ti / o.repeat;
+  r.markingTime        = tm / o.repeat;
+  r.localMoveTime      = tl / o.repeat;
+  r.aggregationTime    = ta / o.repeat;
+  r.lookupTime         = tk / o.repeat;
+  r.passTime       = tp;
+  r.passIterations = lp;
+  r.passVertices   = np;
+  multiplyValue(r.passTime, r.passTime, 1.0f/o.repeat);
+  return r;
+}
+
+
+/**
+ * Add time spent outside Louvain (such as marking or aggregation) to a result.
+ * @param a louvain result (updated)
+ * @param t time to add
+ */
+template <class K>
+inline void louvainAddTimeW(LouvainResult<K>& a, float t) {
+  a.time       += t;
+  a.minTime    += t;
+  a.medianTime += t;
+}
+
+
+
+
+// LOUVAIN-DYNAMIC
+// ---------------
+// Dynamic techniques, shared by sequential and parallel Louvain. Each marks
+// affected vertices of a batch update, and runs Louvain (fl) on them, with the
+// aggregated graph updated by the batch beforehand. The driver (fl) takes
+// (x, q, o, fm, fa, fp, z, ws, aff), as louvainSeq() and louvainOmp() do, and
+// scan buffers for marking are chosen by fw (workspace) -> (vcs, vcout).
+
+/**
+ * Run Louvain on vertices affected by a batch update.
+ * @param fl louvain driver
+ * @param fm mark affected vertices (vcom, vtot, ctot), before the first pass
+ * @param fp process vertices whose communities have changed (first pass)
+ * @param x updated graph
+ * @param batch edge weight deltas for this batch update (undirected, grouped by source vertex)
+ * @param q initial community each vertex belongs to (before the update)
+ * @param o louvain options
+ * @param z aggregated graph as per q, without the batch applied (updated to final communities)
+ * @param ws workspace reused across calls (updated)
+ * @param vaff affected vertices (updated)
+ * @returns louvain result
+ */
+template <class FL, class FM, class FP, class G, class K, class V>
+inline auto louvainDynamicAffected(FL fl, FM fm, FP fp, const G& x, const EdgeBatch<K, V>& batch, const vector<K>* q, const LouvainOptions<V>& o, G* z, LouvainWorkspace<K, V>* ws, AffectedSet<K>& vaff) {
+  auto fa = [&](auto u) { return vaff.has(u); };
+  vector<K> qx;  // with new vertices in their own community
+  if (q && q->size() < size_t(x.span())) { qx = louvainCommunitiesFrom(x, *q); q = &qx; }
+  float tz = z? measureDuration([&]() { louvainAggregateEdgesW(*z, batch, *q); }) : 0;
+  auto a  = fl(x, q, o, fm, fa, fp, z, ws, &vaff);
+  louvainAddTimeW(a, tz);
+  a.aggregationTime += tz;
+  a.affectedVertices = vaff.size();
+  return a;
+}
+
+
+/**
+ * Find communities upon a batch update, with the delta-screening technique.
+ * @param fl louvain driver
+ * @param fw scan buffers of workspace, for marking
+ * @param x updated graph
+ * @param batch edge weight deltas for this batch update (undirected, grouped by source vertex)
+ * @param q initial community each vertex belongs to (before the update)
+ * @param o louvain options
+ * @param z aggregated graph as per q, without the batch applied (updated to final communities)
+ * @param ws workspace reused across calls (updated)
+ * @returns louvain result
+ */
+template <class FL, class FW, class G, class K, class V>
+inline auto louvainDynamicDeltaScreeningWith(FL fl, FW fw, const G& x, const EdgeBatch<K, V>& batch, const vector<K>* q, const LouvainOptions<V>& o, G* z, LouvainWorkspace<K, V>* ws) {
+  V R = o.resolution;
+  V M = edgeWeight(x)/2;
+  LouvainWorkspace<K, V> wl;
+  auto& wk = ws? *ws : wl;
+  AffectedSet<K> vaff(o.affected);
+  // Scan buffers of workspace are grown and cleared before marking.
+  auto fm = [&](const auto& vcom, const auto& vtot, const auto& ctot) {
+    auto [vcs, vcout] = fw(wk);
+    louvainAffectedVerticesDeltaScreeningW(vaff, vcs, vcout, wk.coff, wk.cmem, x, batch, vcom, vtot, ctot, M, R);
+  };
+  auto fp = [](auto u) {};
+  return louvainDynamicAffected(fl, fm, fp, x, batch, q, o, z, &wk, vaff);
+}
+
+
+/**
+ * Find communities upon a batch update, with the frontier technique.
+ * @param fl louvain driver
+ * @param x updated graph
+ * @param batch edge weight deltas for this batch update (undirected, grouped by source vertex)
+ * @param q initial community each vertex belongs to (before the update)
+ * @param o louvain options
+ * @param z aggregated graph as per q, without the batch applied (updated to final communities)
+ * @param ws workspace reused across calls (updated)
+ * @returns louvain result
+ */
+template <class FL, class G, class K, class V>
+inline auto louvainDynamicFrontierWith(FL fl, const G& x, const EdgeBatch<K, V>& batch, const vector<K>* q, const LouvainOptions<V>& o, G* z, LouvainWorkspace<K, V>* ws) {
+  AffectedSet<K> vaff(o.affected);  // written concurrently, if parallel
+  auto fm = [&](const auto& vcom, const auto& vtot, const auto& ctot) { louvainAffectedVerticesFrontierW(vaff, x, batch, vcom); };
+  auto fp = [&](auto u) { x.forEachEdgeKey(u, [&](auto v) { vaff.add(v); }); };
+  return louvainDynamicAffected(fl, fm, fp, x, batch, q, o, z, ws, vaff);
+}
+
+
+/**
+ * Find communities upon a batch update, with delta-screening seeding the frontier technique.
+ * @param fl louvain driver
+ * @param fw scan buffers of workspace, for marking
+ * @param x updated graph
+ * @param batch edge weight deltas for this batch update (undirected, grouped by source vertex)
+ * @param q initial community each vertex belongs to (before the update)
+ * @param o louvain options
+ * @param z aggregated graph as per q, without the batch applied (updated to final communities)
+ * @param ws workspace reused across calls (updated)
+ * @returns louvain result
+ */
+template <class FL, class FW, class G, class K, class V>
+inline auto louvainDynamicDeltaFrontierWith(FL fl, FW fw, const G& x, const EdgeBatch<K, V>& batch, const vector<K>* q, const LouvainOptions<V>& o, G* z, LouvainWorkspace<K, V>* ws) {
+  V R = o.resolution;
+  V M = edgeWeight(x)/2;
+  LouvainWorkspace<K, V> wl;
+  auto& wk = ws? *ws : wl;
+  AffectedSet<K> vaff(o.affected);  // written concurrently, if parallel
+  auto fm = [&](const auto& vcom, const auto& vtot, const auto& ctot) {
+    auto [vcs, vcout] = fw(wk);
+    louvainAffectedVerticesDeltaFrontierW(vaff, vcs, vcout, x, batch, vcom, vtot, ctot, M, R);
+  };
+  auto fp = [&](auto u) { x.forEachEdgeKey(u, [&](auto v) { vaff.add(v); }); };
+  return louvainDynamicAffected(fl, fm, fp, x, batch, q, o, z, &wk, vaff);
+}
+
+
+/**
+ * Find communities upon a batch update, with a technique chosen by its estimated affected fraction.
+ * @param fl louvain driver
+ * @param fw scan buffers of workspace, for marking
+ * @param fz aggregate graph (x, vcom, ws), for techniques that do not maintain it
+ * @param x updated graph
+ * @param batch edge weight deltas for this batch update (undirected, grouped by source vertex)
+ * @param q initial community each vertex belongs to (before the update)
+ * @param o louvain options (with limits of each technique)
+ * @param z aggregated graph as per q, without the batch applied (updated to final communities)
+ * @param ws workspace reused across calls (updated)
+ * @returns result, with chosen technique and estimated affected fraction
+ */
+template <class FL, class FW, class FZ, class G, class K, class V>
+inline auto louvainDynamicAutoWith(FL fl, FW fw, FZ fz, const G& x, const EdgeBatch<K, V>& batch, const vector<K>* q, const LouvainOptions<V>& o, G* z, LouvainWorkspace<K, V>* ws) {
+  double f = 1;
+  int    t = LOUVAIN_TECHNIQUE_STATIC;
+  vector<K> qx;  // with new vertices in their own community
+  if (q && q->size() < size_t(x.span())) { qx = louvainCommunitiesFrom(x, *q); q = &qx; }
+  float tm = measureDuration([&]() {
+    f = q? louvainEstimateAffectedFraction(x, batch, *q) : 1;
+    t = louvainAutoTechnique(f, o.autoLimits, q!=nullptr);
+  });
+  auto fm = [](const auto& vcom, const auto& vtot, const auto& ctot) {};
+  auto fa = [](auto u) { return true; };
+  auto fp = [](auto u) {};
+  auto fr = [&]() {
+    switch (t) {
+      case LOUVAIN_TECHNIQUE_FRONTIER:        return louvainDynamicFrontierWith(fl, x, batch, q, o, z, ws);
+      case LOUVAIN_TECHNIQUE_DELTA_SCREENING: return louvainDynamicDeltaScreeningWith(fl, fw, x, batch, q, o, z, ws);
+      case LOUVAIN_TECHNIQUE_NAIVE_DYNAMIC:   return fl(x, q, o, fm, fa, fp, (G*) nullptr, ws, (AffectedSet<K>*) nullptr);
+      default: return fl(x, (const vector<K>*) nullptr, o, fm, fa, fp, (G*) nullptr, ws, (AffectedSet<K>*) nullptr);
+    }
+  };
+  auto a = fr();
+  // Naive-dynamic and static do not maintain the aggregated graph.
+  if (t==LOUVAIN_TECHNIQUE_NAIVE_DYNAMIC || t==LOUVAIN_TECHNIQUE_STATIC) {
+    float tz = measureDuration([&]() {
+      if (z) *z = fz(x, a.membership, ws);
+    });
+    louvainAddTimeW(a, tz);
+    a.aggregationTime += tz;
+    if (z) a.aggregateBytes = max(a.aggregateBytes, z->bytes());
+  }
+  louvainAddTimeW(a, tm);
+  a.markingTime += tm;
+  a.technique = t;
+  a.estimatedAffected = f;
+  return a;
 }
@@ -0,0 +1,76 @@
+#pragma once
+#include <utility>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include "_main.hxx"
+#include "louvain.hxx"
+#include "louvainSeq.hxx"
+
+using std::declval;
+using std::vector;
+using std::iota;
+using std::sort;
+
+
+
+
+// LOUVAIN-MANY
+// ------------
+// Find communities of many independent (small) graphs, with one run of
+// sequential Louvain per graph as a task. Tasks are spread across the threads
+// of the enclosing OpenMP settings, largest graphs first, so that throughput
+// scales with cores without any parallelism within a graph. Each thread
+// reuses its own workspace across the graphs it processes.
+
+/**
+ * Run a task per graph across threads, with a workspace per thread.
+ * @param N number of graphs
+ * @param fx get graph (i)
+ * @param fl run louvain on graph (x, i, ws), returning result
+ * @param wss workspace per thread, reused across calls (updated, optional)
+ * @returns louvain result per graph
+ */
+template <class K, class V, class FX, class FL>
+auto louvainManyOmp(size_t N, FX fx, FL fl, vector<LouvainWorkspace<K, V>>* wss=nullptr) {
+  using R = decltype(fl(fx(0), size_t(), declval<LouvainWorkspace<K, V>&>()));
+  size_t T = ompMaxThreads();
+  vector<LouvainWorkspace<K, V>> wl;
+  auto& wk = wss? *wss : wl;
+  if (wk.size() < T) wk.resize(T);
+  // Largest graphs first, to avoid a long task at the end.
+  vector<size_t> is(N);
+  iota(is.begin(), is.end(), size_t());
+  sort(is.begin(), is.end(), [&](size_t i, size_t j) { return fx(i).size() > fx(j).size(); });
+  vector<R> a(N, R(vector<K>()));
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (size_t n=0; n<N; ++n) {
+    size_t i = is[n];
+    int    t = ompThreadNum();
+    a[i] = fl(fx(i), i, wk[t]);
+  }
+  return a;
+}
+
+
+/**
+ * Find the communities of many independent graphs, with static sequential Louvain on each in parallel.
+ * Progress callback in options, if any, is called concurrently.
+ * @param xs graphs
+ * @param qs initial community each vertex belongs to, per graph (optional)
+ * @param o louvain options
+ * @param wss workspace per thread, reused across calls (updated, optional)
+ * @returns louvain result per graph
+ */
+template <class G, class K=typename G::key_type, class V=float>
+inline auto louvainSeqStaticMany(const vector<const G*>& xs, const vector<const vector<K>*>* qs=nullptr, const LouvainOptions<V>& o={}, vector<LouvainWorkspace<K, V>>* wss=nullptr) {
+  auto fx = [&](size_t i) -> const G& { return *xs[i]; };
+  auto fl = [&](const G& x, size_t i, auto& ws) { return louvainSeqStatic(x, qs? (*qs)[i] : nullptr, o, &ws); };
+  return louvainManyOmp<K, V>(xs.size(), fx, fl, wss);
+}
+template <class G, class K=typename G::key_type, class V=float>
+inline auto louvainSeqStaticMany(const vector<G>& xs, const vector<const vector<K>*>* qs=nullptr, const LouvainOptions<V>& o={}, vector<LouvainWorkspace<K, V>>* wss=nullptr) {
+  auto fx = [&](size_t i) -> const G& { return xs[i]; };
+  auto fl = [&](const G& x, size_t i, auto& ws) { return louvainSeqStatic(x, qs? (*qs)[i] : nullptr, o, &ws); };
+  return louvainManyOmp<K, V>(xs.size(), fx, fl, wss);
+}
@@ -0,0 +1,295 @@
+#pragma once
+#include <utility>
+#include <vector>
+#include <algorithm>
+#include "_main.hxx"
+#include "properties.hxx"
+#include "duplicate.hxx"
+#include "update.hxx"
+#include "modularity.hxx"
+#include "louvain.hxx"
+
+using std::tuple;
+using std::vector;
+using std::min;
+using std::max;
+using std::count;
+
+
+
+
+// LOUVAIN-OMP
+// -----------
+
+/**
+ * Find the community each vertex belongs to, with the parallel Louvain algorithm.
+ * Thread count and loop schedule are those of the enclosing OpenMP settings
+ * (omp_set_num_threads(), omp_set_schedule()).
+ * @param x original graph
+ * @param q initial community each vertex belongs to
+ * @param o louvain options
+ * @param fm mark affected vertices (vcom, vtot, ctot), before the first pass
+ * @param fa is a vertex affected? (first pass, called concurrently)
+ * @param fp process vertices whose communities have changed (first pass, called concurrently)
+ * @param z aggregated graph as per q, with batch already applied (updated to final communities)
+ * @param ws workspace reused across calls (updated)
+ * @param aff affected vertices marked by fm, visited directly in the first pass (updated, optional)
+ * @returns louvain result (truncated if stopped by time budget or cancellation)
+ */
+template <class G, class K, class V, class FM, class FA, class FP>
+auto louvainOmp(const G& x, const vector<K>* q, const LouvainOptions<V>& o, FM fm, FA fa, FP fp, G* z=nullptr, LouvainWorkspace<K, V>* ws=nullptr, AffectedSet<K>* aff=nullptr) {
+  V   R = o.resolution;
+  V   D = o.passTolerance;
+  int L = o.maxIterations, l = 0;
+  int P = o.maxPasses, p = 0;
+  K   S = x.span();
+  V   M = edgeWeight(x)/2;
+  LouvainWorkspace<K, V> wl;
+  auto& wk = ws? *ws : wl;
+  louvainGrowWorkspaceOmp(wk, S, o.numa);
+  auto& vcom = wk.vcom, &a = wk.a, &cmap = wk.cmap;
+  auto& vtot = wk.vtot, &ctot = wk.ctot, &csiz = wk.csiz;
+  auto& vcsp = wk.vcsp; auto& vcoutp = wk.vcoutp;
+  for (auto& vcs : vcsp) vcs.clear();
+  for (auto& vcout : vcoutp) fillValueOmpU(vcout, V());
+  vector<float> tp; vector<int> lp; vector<K> np;
+  float ti = 0, tm = 0, tl = 0, ta = 0, tk = 0;
+  size_t T = ompMaxThreads();
+  size_t n = o.balance? 16*T : 0;  // chunks, for dynamic load balance
+  bool  fb = o.balance || o.hubDegree;
+  vector<float> tb(T);
+  LouvainPartition<K> pt;
+  vector<K> vcol; vector2d<K> forbp(T);  // for coloring
+  bool  fs = o.conflict==LOUVAIN_CONFLICT_SINGLETON;
+  bool  fc = o.conflict==LOUVAIN_CONFLICT_COLOR;
+  auto ft = [](auto u) { return true; };
+  auto fn = [](auto u) {};
+  G zf; int run = 0;
+  bool truncated = false;
+  size_t gb = 0, zb = 0;  // bytes of working graph, largest aggregated graph
+  ASSERT(!z || q);
+  auto ts = measureDurationsMarked([&](auto mark) {
+    // Discard phase timings of warm-up runs.
+    if (run++ == o.warmup) {
+      ti = tm = tl = ta = tk = 0;
+      tp.clear();
+      fillValueU(tb, 0.0f);
+    }
+    V E  = o.tolerance;
+    V Q0 = modularity(x, M, R);
+    G y  = o.numa!=NUMA_DEFAULT? duplicateOmp(x) : duplicate(x);
+    G w  = z? duplicate(*z) : G();
+    gb = y.bytes();
+    zb = z? w.bytes() : 0;
+    fillValueOmpU(vcom, K());
+    fillValueOmpU(vtot, V());
+    fillValueOmpU(ctot, V());
+    lp.clear(); np.clear();
+    mark([&]() {
+      LouvainBudget bg(o.timeBudget, o.cancel, &o.progress);
+      auto t0 = timeNow();
+      louvainVertexWeightsOmp(vtot, y);
+      if (q) louvainInitializeFromOmp(vcom, ctot, x, vtot, *q);
+      else   louvainInitializeOmp(vcom, ctot, y, vtot);
+      #pragma omp parallel for schedule(static)
+      for (K u=0; u<S; ++u) a[u] = u;
+      auto t1 = timeNow();
+      fm(vcom, vtot, ctot);
+      auto t2 = timeNow();
+      ti += durationMilliseconds(t0, t1);
+      tm += durationMilliseconds(t1, t2);
+      for (l=0, p=0; M>0 && p<P;) {
+        int m = 0;
+        auto t3 = timeNow();
+        if (fb) louvainPartitionOmp(pt, y, n, o.hubDegree);
+        if (fc) louvainPartitionColorsOmp(pt, vcol, forbp, y);
+        if (fs) { fillValueOmpU(csiz, 0, S, K()); louvainCommunitySizesOmp(csiz, y, vcom); }
+        auto *cs = fs? &csiz : nullptr;
+        bg.setPass(p);
+        if (p==0 && aff) m = louvainMoveOmp(vcom, ctot, cs, vcsp, vcoutp, tb, y, pt, vtot, M, R, E, L, *aff, fp, &bg);
+        else if (p==0)   m = louvainMoveOmp(vcom, ctot, cs, vcsp, vcoutp, tb, y, pt, vtot, M, R, E, L, fa, fp, (AffectedSet<K>*) nullptr, &bg);
+        else             m = louvainMoveOmp(vcom, ctot, cs, vcsp, vcoutp, tb, y, pt, vtot, M, R, E, L, ft, fn, (AffectedSet<K>*) nullptr, &bg);
+        auto t4 = timeNow();
+        tl += durationMilliseconds(t3, t4);
+        if (tp.size()<=size_t(p)) tp.push_back(0);
+        lp.push_back(m);
+        np.push_back(y.order());
+        l += m; ++p;
+        if (z && p==1) louvainAggregateMovesW(w, y, *q, vcom);
+        // Stop after a pass whose local-moving was stopped (by time budget or cancellation).
+        if (m<=1 || p>=P || bg.stopped()) {
+          if (!z || p>1) louvainRenumberCommunities(vcom, cmap, y);
+          auto t5 = timeNow();
+          louvainLookupCommunitiesOmp(a, vcom);
+          auto t6 = timeNow();
+          if (z) zf = p==1? move(w) : louvainAggregateOmp(vcsp, vcoutp, tb, y, vcom, n);
+          auto t7 = timeNow();
+          tk += durationMilliseconds(t5, t6);
+          ta += durationMilliseconds(t4, t5) + durationMilliseconds(t6, t7);
+          tp[p-1] += durationMilliseconds(t3, t7);
+          truncated |= bg.stopped();
+          if (z) zb = max(zb, zf.bytes());
+          break;
+        }
+        // K N0 = y.order();
+        // Incrementally maintained aggregate keeps community ids of q.
+        if (z && p==1) y = move(w);
+        else { louvainRenumberCommunities(vcom, cmap, y); y = louvainAggregateOmp(vcsp, vcoutp, tb, y, vcom, n); }
+        zb = max(zb, y.bytes());
+        // K N1 = y.order();
+        // if (N1==N0) break;
+        auto t5 = timeNow();
+        louvainLookupCommunitiesOmp(a, vcom);
+        auto t6 = timeNow();
+        ta += durationMilliseconds(t4, t5);
+        tk += durationMilliseconds(t5, t6);
+        PRINTFD("louvainOmp(): p=%d, l=%d, m=%d, Q=%f\n", p, l, m, modularity(y, M, R));
+        V Q = D? modularity(y, M, R) : V();
+        if (D && Q-Q0<=D) { if (z) zf = y; tp[p-1] += durationMilliseconds(t3, timeNow()); break; }
+        auto t7 = timeNow();
+        fillValueOmpU(vcom, 0, y.span(), K());
+        fillValueOmpU(vtot, 0, y.span(), V());
+        fillValueOmpU(ctot, 0, y.span(), V());
+        louvainVertexWeightsOmp(vtot, y);
+        louvainInitializeOmp(vcom, ctot, y, vtot);
+        auto t8 = timeNow();
+        ti += durationMilliseconds(t7, t8);
+        tp[p-1] += durationMilliseconds(t3, t8);
+        E /= o.tolerenceDeclineFactor;
+        Q0 = Q;
+      }
+    });
+  }, o.repeat, o.warmup);
+  louvainAbsentCommunitiesW(a, x);
+  if (z) *z = move(zf);
+  auto r = louvainResultFrom(x, a, l, p, ts, o, ti, tm, tl, ta, tk, tp, lp, np);
+  r.truncated  = truncated;
+  r.graphBytes     = gb;
+  r.aggregateBytes = zb;
+  r.workspaceBytes = louvainWorkspaceBytes(wk);
+  r.affectedBytes  = aff? aff->bytes() : 0;
+  r.threadBusyTime = tb;
+  multiplyValue(r.threadBusyTime, r.threadBusyTime, 1.0f/o.repeat);
+  return r;
+}
+template <class G, class K, class V, class FA, class FP>
+inline auto louvainOmp(const G& x, const vector<K>* q, const LouvainOptions<V>& o, FA fa, FP fp) {
+  auto fm = [](const auto& vcom, const auto& vtot, const auto& ctot) {};
+  return louvainOmp(x, q, o, fm, fa, fp);
+}
+template <class G, class K, class V, class FA>
+inline auto louvainOmp(const G& x, const vector<K>* q, const LouvainOptions<V>& o, FA fa) {
+  auto fp = [](auto u) {};
+  return louvainOmp(x, q, o, fa, fp);
+}
+template <class G, class K, class V>
+inline auto louvainOmp(const G& x, const vector<K>* q, const LouvainOptions<V>& o) {
+  auto fa = [](auto u) { return true; };
+  return louvainOmp(x, q, o, fa);
+}
+
+
+
+
+// LOUVAIN-OMP-STATIC
+// ------------------
+
+template <class G, class K, class V=float>
+inline auto louvainOmpStatic(const G& x, const vector<K>* q=nullptr, const LouvainOptions<V>& o={}, LouvainWorkspace<K, V>* ws=nullptr) {
+  auto fm = [](const auto& vcom, const auto& vtot, const auto& ctot) {};
+  auto fa = [](auto u) { return true; };
+  auto fp = [](auto u) {};
+  return louvainOmp(x, q, o, fm, fa, fp, (G*) nullptr, ws);
+}
+
+
+
+
+// LOUVAIN-OMP-DYNAMIC-DELTA-SCREENING
+// -----------------------------------
+
+template <class G, class K, class V>
+inline auto louvainOmpDynamicDeltaScreening(const G& x, const EdgeBatch<K, V>& batch, const vector<K>* q, const LouvainOptions<V>& o={}, G* z=nullptr, LouvainWorkspace<K, V>* ws=nullptr) {
+  auto fl = [](auto&&... args) { return louvainOmp(args...); };
+  auto fw = [](auto& wk) { return tie(wk.vcsp[0], wk.vcoutp[0]); };
+  return louvainDynamicDeltaScreeningWith(fl, fw, x, batch, q, o, z, ws);
+}
+template <class G, class K, class V>
+inline auto louvainOmpDynamicDeltaScreening(const G& x, const vector<tuple<K, K, V>>& updates, const vector<K>* q, const LouvainOptions<V>& o={}, G* z=nullptr, LouvainWorkspace<K, V>* ws=nullptr) {
+  return louvainOmpDynamicDeltaScreening(x, edgeBatchOmp(updates, x.span()), q, o, z, ws);
+}
+template <class G, class K, class V>
+inline auto louvainOmpDynamicDeltaScreening(const G& x, const vector<tuple<K, K, V>>& deletions, const vector<tuple<K, K, V>>& insertions, const vector<K>* q, const LouvainOptions<V>& o={}, G* z=nullptr, LouvainWorkspace<K, V>* ws=nullptr) {
+  return louvainOmpDynamicDeltaScreening(x, edgeUpdates(deletions, insertions), q, o, z, ws);
+}
+
+
+
+
+// LOUVAIN-OMP-DYNAMIC-FRONTIER
+// ----------------------------
+
+template <class G, class K, class V>
+inline auto louvainOmpDynamicFrontier(const G& x, const EdgeBatch<K, V>& batch, const vector<K>* q, const LouvainOptions<V>& o={}, G* z=nullptr, LouvainWorkspace<K, V>* ws=nullptr) {
+  auto fl = [](auto&&... args) { return louvainOmp(args...); };
+  return louvainDynamicFrontierWith(fl, x, batch, q, o, z, ws);
+}
+template <class G, class K, class V>
+inline auto louvainOmpDynamicFrontier(const G& x, const vector<tuple<K, K, V>>& updates, const vector<K>* q, const LouvainOptions<V>& o={}, G* z=nullptr, LouvainWorkspace<K, V>* ws=nullptr) {
+  return louvainOmpDynamicFrontier(x, edgeBatchOmp(updates, x.span()), q, o, z, ws);
+}
+template <class G, class K, class V>
+inline auto louvainOmpDynamicFrontier(const G& x, const vector<tuple<K, K, V>>& deletions, const vector<tuple<K, K, V>>& insertions, const vector<K>* q, const LouvainOptions<V>& o={}, G* z=nullptr, LouvainWorkspace<K, V>* ws=nullptr) {
+  return louvainOmpDynamicFrontier(x, edgeUpdates(deletions, insertions), q, o, z, ws);
+}
+
+
+
+
+// LOUVAIN-OMP-DYNAMIC-DELTA-FRONTIER
+// ----------------------------------
+
+template <class G, class K, class V>
+inline auto louvainOmpDynamicDeltaFrontier(const G& x, const EdgeBatch<K, V>& batch, const vector<K>* q, const LouvainOptions<V>& o={}, G* z=nullptr, LouvainWorkspace<K, V>* ws=nullptr) {
+  auto fl = [](auto&&... args) { return louvainOmp(args...); };
+  auto fw = [](auto& wk) { return tie(wk.vcsp[0], wk.vcoutp[0]); };
+  return louvainDynamicDeltaFrontierWith(fl, fw, x, batch, q, o, z, ws);
+}
+template <class G, class K, class V>
+inline auto louvainOmpDynamicDeltaFrontier(const G& x, const vector<tuple<K, K, V>>& updates, const vector<K>* q, const LouvainOptions<V>& o={}, G* z=nullptr, LouvainWorkspace<K, V>* ws=nullptr) {
+  return louvainOmpDynamicDeltaFrontier(x, edgeBatchOmp(updates, x.span()), q, o, z, ws);
+}
+
+
+
+
+// LOUVAIN-OMP-DYNAMIC-AUTO
+// ------------------------
+
+/**
+ * Find communities upon a batch update, with a technique chosen by its estimated affected fraction.
+ * @param x updated graph
+ * @param batch edge weight deltas for this batch update (undirected, grouped by source vertex)
+ * @param q initial community each vertex belongs to (before the update)
+ * @param o louvain options (with limits of each technique)
+ * @param z aggregated graph as per q, without the batch applied (updated to final communities)
+ * @param ws workspace to reuse across calls
+ * @returns result, with chosen technique and estimated affected fraction
+ */
+template <class G, class K, class V>
+inline auto louvainOmpDynamicAuto(const G& x, const EdgeBatch<K, V>& batch, const vector<K>* q, const LouvainOptions<V>& o={}, G* z=nullptr, LouvainWorkspace<K, V>* ws=nullptr) {
+  auto fl = [](auto&&... args) { return louvainOmp(args...); };
+  auto fw = [](auto& wk) { return tie(wk.vcsp[0], wk.vcoutp[0]); };
+  auto fz = [&](const G& x, const vector<K>& vcom, LouvainWorkspace<K, V>* ws) {
+    LouvainWorkspace<K, V> wl;
+    auto& wk = ws? *ws : wl;
+    vector<float> tb(ompMaxThreads());
+    louvainGrowWorkspaceOmp(wk, x.span(), o.numa);
+    return louvainAggregateOmp(wk.vcsp, wk.vcoutp, tb, x, vcom);
+  };
+  return louvainDynamicAutoWith(fl, fw, fz, x, batch, q, o, z, ws);
+}
+template <class G, class K, class V>
+inline auto louvainOmpDynamicAuto(const G& x, const vector<tuple<K, K, V>>& updates, const vector<K>* q, const LouvainOptions<V>& o={}, G* z=nullptr, LouvainWorkspace<K, V>* ws=nullptr) {
+  return louvainOmpDynamicAuto(x, edgeBatchOmp(updates, x.span()), q, o, z, ws);
+}
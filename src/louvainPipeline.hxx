@@ -0,0 +1,130 @@
+#pragma once
+#include <tuple>
+#include <vector>
+#include <thread>
+#include <utility>
+#include "_main.hxx"
+#include "update.hxx"
+#include "louvain.hxx"
+
+using std::tuple;
+using std::vector;
+using std::thread;
+using std::swap;
+
+
+
+
+// LOUVAIN-PIPELINE
+// ----------------
+// Overlap preparation of the next batch update with community detection on
+// the current one, for a continuous stream of updates.
+//
+// The graph is double-buffered. While dynamic Louvain runs on the current
+// graph (with batches upto k applied), a staging thread generates batch k+1,
+// sorts it into an EdgeBatch, and applies batches k and k+1 to the shadow
+// graph (which lags by one batch). The two graphs are swapped at batch
+// boundaries, so each batch is applied twice, but off the critical path.
+// Batches are applied with updateEdgeWeightsOmpU(), which also adds vertices
+// new to the graph, so that both graphs match the graph the batches came from.
+
+struct LouvainPipelineStats {
+  size_t batches = 0;  // batches processed
+  size_t updates = 0;  // update records processed
+  float  louvainTime = 0;  // time spent in dynamic Louvain (ms)
+  float  stageTime   = 0;  // time spent staging batches, overlapped (ms)
+  float  waitTime    = 0;  // time spent waiting for a batch to be staged (ms)
+  float  totalTime   = 0;  // wall-clock time of the stream (ms)
+
+  /** Updates processed per second, over wall-clock time. */
+  inline double throughput() const { return totalTime>0? 1000.0 * updates / totalTime : 0; }
+  /** Fraction of wall-clock time spent in dynamic Louvain (1 when staging is fully hidden). */
+  inline double overlap() const { return totalTime>0? louvainTime / totalTime : 0; }
+};
+
+
+template <class G, class K, class V>
+class LouvainPipeline {
+  // Data.
+  protected:
+  G gc;          // current graph, read by dynamic Louvain
+  G gs;          // shadow graph, updated by staging thread (one batch behind)
+  G z;           // aggregated graph of current communities
+  vector<K> vcom;
+  LouvainWorkspace<K, V> ws;
+  LouvainPipelineStats   st;
+  bool symmetric;
+  int  stageThreads;
+
+
+  // Property operations.
+  public:
+  inline const G& graph() const noexcept { return gc; }
+  inline const vector<K>& membership() const noexcept { return vcom; }
+  inline const LouvainPipelineStats& stats() const noexcept { return st; }
+
+
+  // Update operations.
+  public:
+  /**
+   * Process a stream of batch updates, staging each one while the previous is processed.
+   * @param N number of batches
+   * @param fb get batch updates (i), called from staging thread in order
+   * @param fl run dynamic Louvain (graph, batch, communities, aggregated graph, workspace), returning result
+   * @param fr report result (i, graph, batch, result), on calling thread
+   */
+  template <class FB, class FL, class FR>
+  void run(int N, FB fb, FL fl, FR fr) {
+    EdgeBatch<K, V> bc, bs;  // current, staged
+    size_t nc = 0, ns = 0;   // update records in them
+    auto fs = [&](int i, const EdgeBatch<K, V>* bp) {
+      #ifdef _OPENMP
+      omp_set_num_threads(stageThreads);
+      #endif
+      auto t0 = timeNow();
+      auto updates = fb(i);
+      ns = updates.size();
+      bs = edgeBatchOmp(updates, gs.span(), symmetric);
+      if (bp) updateEdgeWeightsOmpU(gs, *bp);
+      updateEdgeWeightsOmpU(gs, bs);
+      st.stageTime += durationMilliseconds(t0, timeNow());
+    };
+    if (N<=0) return;
+    auto t0 = timeNow();
+    fs(0, nullptr);
+    for (int i=0; i<N; ++i) {
+      // Shadow graph now has batch i; swap it in, and stage next batch.
+      swap(gc, gs);
+      swap(bc, bs); nc = ns;
+      thread ts;
+      if (i+1<N) ts = thread(fs, i+1, &bc);
+      auto t1 = timeNow();
+      auto a  = fl(gc, bc, vcom, z, ws);
+      auto t2 = timeNow();
+      st.louvainTime += durationMilliseconds(t1, t2);
+      vcom = a.membership;
+      ++st.batches;
+      st.updates += nc;
+      fr(i, gc, bc, a);
+      auto t3 = timeNow();
+      if (ts.joinable()) ts.join();
+      st.waitTime += durationMilliseconds(t3, timeNow());
+    }
+    // Bring shadow graph upto date.
+    updateEdgeWeightsOmpU(gs, bc);
+    st.totalTime += durationMilliseconds(t0, timeNow());
+  }
+
+
+  // Constructors.
+  public:
+  /**
+   * Set up pipeline for a graph, with its current communities.
+   * @param x original graph
+   * @param q current community of each vertex
+   * @param symmetric add reverse records of edges given in one direction only?
+   * @param stageThreads threads used by staging thread (for parallel sort and apply)
+   */
+  LouvainPipeline(const G& x, const vector<K>& q, bool symmetric=true, int stageThreads=1) :
+  gc(duplicate(x)), gs(duplicate(x)), z(louvainAggregate(x, q)), vcom(q), symmetric(symmetric), stageThreads(stageThreads) {}
+};
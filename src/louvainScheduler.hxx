@@ -0,0 +1,207 @@
+#pragma once
+#include <tuple>
+#include <vector>
+#include <algorithm>
+#include "_main.hxx"
+#include "update.hxx"
+#include "louvain.hxx"
+#include "louvainSeq.hxx"
+
+using std::tuple;
+using std::vector;
+using std::get;
+using std::max;
+
+
+
+
+// LOUVAIN-SCHEDULER
+// -----------------
+// Coalesce a stream of edge updates into batches for dynamic Louvain.
+// Updates are buffered as they arrive, and a run of Dynamic Frontier Louvain
+// is triggered when the buffered batch becomes large enough, when it is
+// expected to affect a large enough fraction of vertices, or when its oldest
+// update has waited for the latency budget. Deltas of the same edge are merged
+// when the batch is prepared, so that an insertion and a deletion of the same
+// edge within a batch cancel out.
+//
+// Triggers are only checked when updates are pushed, or when poll() is called.
+// The scheduler has no timer of its own, so a caller using a latency budget
+// must call poll() periodically (or flush()) while the stream is quiet.
+// Updates may name vertices beyond the span of the graph, which are added.
+
+#define LOUVAIN_TRIGGER_NONE     0
+#define LOUVAIN_TRIGGER_SIZE     1
+#define LOUVAIN_TRIGGER_AFFECTED 2
+#define LOUVAIN_TRIGGER_LATENCY  3
+#define LOUVAIN_TRIGGER_FLUSH    4
+
+
+struct LouvainSchedulerOptions {
+  size_t batchSize;          // run once so many updates are buffered (0: no limit)
+  double affectedFraction;   // run once updates touch this fraction of vertices (0: no limit)
+  float  latencyBudget;      // run once the oldest buffered update has waited so long, in ms (0: no limit)
+  bool   symmetric;          // add reverse records of edges given in one direction only?
+
+  LouvainSchedulerOptions(size_t batchSize=0, double affectedFraction=0, float latencyBudget=0, bool symmetric=true) :
+  batchSize(batchSize), affectedFraction(affectedFraction), latencyBudget(latencyBudget), symmetric(symmetric) {}
+};
+
+
+struct LouvainSchedulerStats {
+  size_t runs      = 0;  // runs of dynamic Louvain
+  size_t received  = 0;  // update records received
+  size_t processed = 0;  // update records in triggered runs
+  size_t applied   = 0;  // edge deltas applied, after merging (both directions)
+  size_t triggers[5] = {};  // runs by trigger (none, size, affected, latency, flush)
+  float  processingTime = 0;  // time spent updating graph and running Louvain (ms)
+  float  elapsedTime    = 0;  // time since first update, upto last run (ms)
+  double stalenessSum   = 0;  // sum over processed updates of time from arrival to result (ms)
+  float  stalenessMax   = 0;  // longest time from arrival of an update to its result (ms)
+
+  /** Updates processed per second, over elapsed time. */
+  inline double throughput() const { return elapsedTime>0? 1000.0 * processed / elapsedTime : 0; }
+  /** Mean time from arrival of an update to its result (ms). */
+  inline double stalenessMean() const { return processed>0? stalenessSum / processed : 0; }
+};
+
+
+template <class G, class K, class V>
+class LouvainScheduler {
+  // Data.
+  protected:
+  G& x;                  // graph being updated
+  G  z;                  // aggregated graph of current communities
+  vector<K> vcom;        // current community of each vertex
+  LouvainOptions<V>       o;
+  LouvainSchedulerOptions so;
+  LouvainWorkspace<K, V>  ws;
+  LouvainResult<K>        res;  // of last run
+  LouvainSchedulerStats   st;
+  vector<tuple<K, K, V>> buf;   // buffered updates
+  vector<char> vtch;     // is vertex touched by buffered updates?
+  vector<K>    tchs;     // vertices touched by buffered updates
+  // Arrival times, relative to first update (ms).
+  decltype(timeNow()) t0;
+  bool   started = false;
+  float  oldest  = 0;    // of buffered updates
+  double arrivalSum = 0; // of buffered updates
+
+
+  // Property operations.
+  public:
+  inline const vector<K>& membership() const noexcept { return vcom; }
+  inline const LouvainResult<K>& lastResult() const noexcept { return res; }
+  inline const LouvainSchedulerStats& stats() const noexcept { return st; }
+  inline size_t pending() const noexcept { return buf.size(); }
+
+  /** Fraction of vertices touched by buffered updates (estimate of affected fraction). */
+  inline double affectedFraction() const {
+    return x.span()>0? double(tchs.size()) / x.span() : 0;
+  }
+
+
+  // Update operations.
+  public:
+  /**
+   * Buffer incoming updates, and run dynamic Louvain if a trigger is reached.
+   * @param updates edge weight deltas (vertex ids less than span of graph)
+   * @returns trigger of run, or LOUVAIN_TRIGGER_NONE if none
+   */
+  inline int push(const vector<tuple<K, K, V>>& updates) {
+    float t = now();
+    if (buf.empty()) oldest = t;
+    arrivalSum += double(t) * updates.size();
+    st.received += updates.size();
+    for (const auto& e : updates) {
+      buf.push_back(e);
+      touch(get<0>(e));
+      touch(get<1>(e));
+    }
+    return poll();
+  }
+
+  /**
+   * Run dynamic Louvain if a trigger is reached (call periodically for latency budget,
+   * as it is not checked otherwise while no updates arrive).
+   * @returns trigger of run, or LOUVAIN_TRIGGER_NONE if none
+   */
+  inline int poll() {
+    int  t = trigger();
+    if  (t!=LOUVAIN_TRIGGER_NONE) run(t);
+    return t;
+  }
+
+  /**
+   * Run dynamic Louvain on buffered updates, if any.
+   * @returns trigger of run, or LOUVAIN_TRIGGER_NONE if none
+   */
+  inline int flush() {
+    if (buf.empty()) return LOUVAIN_TRIGGER_NONE;
+    run(LOUVAIN_TRIGGER_FLUSH);
+    return LOUVAIN_TRIGGER_FLUSH;
+  }
+
+
+  protected:
+  inline float now() {
+    if (!started) { t0 = timeNow(); started = true; }
+    return durationMilliseconds(t0, timeNow());
+  }
+
+  inline void touch(K u) {
+    if (size_t(u) >= vtch.size()) vtch.resize(u+1);
+    if (vtch[u]) return;
+    vtch[u] = 1;
+    tchs.push_back(u);
+  }
+
+  inline int trigger() {
+    if (buf.empty()) return LOUVAIN_TRIGGER_NONE;
+    if (so.batchSize>0 && buf.size() >= so.batchSize) return LOUVAIN_TRIGGER_SIZE;
+    if (so.affectedFraction>0 && affectedFraction() >= so.affectedFraction) return LOUVAIN_TRIGGER_AFFECTED;
+    if (so.latencyBudget>0 && now() - oldest >= so.latencyBudget) return LOUVAIN_TRIGGER_LATENCY;
+    return LOUVAIN_TRIGGER_NONE;
+  }
+
+  inline void run(int t) {
+    float t1 = now();
+    K    S = max(x.span(), K(vtch.size()));  // including new vertices
+    auto batch = edgeBatchOmp(buf, S, so.symmetric);
+    updateEdgeWeightsOmpU(x, batch);
+    res = louvainSeqDynamicFrontier(x, batch, &vcom, o, &z, &ws);
+    vcom = res.membership;
+    float t2 = now();
+    // Account for the run.
+    size_t N = buf.size();
+    ++st.runs;
+    ++st.triggers[t];
+    st.processed += N;
+    st.applied   += batch.edges.size();
+    st.processingTime += t2 - t1;
+    st.elapsedTime     = t2;
+    st.stalenessSum   += double(t2) * N - arrivalSum;
+    st.stalenessMax    = max(st.stalenessMax, t2 - oldest);
+    // Clear the buffer.
+    for (K u : tchs) vtch[u] = 0;
+    tchs.clear();
+    buf.clear();
+    arrivalSum = 0;
+  }
+
+
+  // Constructors.
+  public:
+  /**
+   * Set up scheduler for a graph, with its current communities.
+   * @param x graph being updated (updated on each run)
+   * @param q current community of each vertex
+   * @param o louvain options (each run is done once, without warm-up)
+   * @param so scheduler options
+   */
+  LouvainScheduler(G& x, const vector<K>& q, const LouvainOptions<V>& o={}, const LouvainSchedulerOptions& so={}) :
+  x(x), z(louvainAggregate(x, q)), vcom(q), o(o), so(so), res(vector<K>()), vtch(x.span()) {
+    this->o.repeat = 1;
+    this->o.warmup = 0;
+  }
+};
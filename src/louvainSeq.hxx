@@ -5,12 +5,15 @@
 #include "_main.hxx"
 #include "properties.hxx"
 #include "duplicate.hxx"
+#include "update.hxx"
 #include "modularity.hxx"
 #include "louvain.hxx"
 
 using std::tuple;
 using std::vector;
 using std::min;
+using std::max;
+using std::count;
 
 
 
@@ -18,53 +21,168 @@ using std::min;
 // LOUVAIN-SEQ
 // -----------
 
-template <class G, class K, class V, class FA, class FP>
-auto louvainSeq(const G& x, const vector<K>* q, const LouvainOptions<V>& o, FA fa, FP fp) {
+/**
+ * Find the community each vertex belongs to, with the Louvain algorithm.
+ * @param x original graph
+ * @param q initial community each vertex belongs to
+ * @param o louvain options
+ * @param fm mark affected vertices (vcom, vtot, ctot), before the first pass
+ * @param fa is a vertex affected? (first pass)
+ * @param fp process vertices whose communities have changed (first pass)
+ * @param z aggregated graph as per q, with batch already applied (updated to final communities)
+ * @param ws workspace reused across calls (updated)
+ * @param aff affected vertices marked by fm, visited directly in the first pass (updated, optional)
+ * @returns louvain result (truncated if stopped by time budget or cancellation)
+ */
+template <class G, class K, class V, class FM, class FA, class FP>
+auto louvainSeq(const G& x, const vector<K>* q, const LouvainOptions<V>& o, FM fm, FA fa, FP fp, G* z=nullptr, LouvainWorkspace<K, V>* ws=nullptr, AffectedSet<K>* aff=nullptr) {
   V   R = o.resolution;
   V   D = o.passTolerance;
   int L = o.maxIterations, l = 0;
   int P = o.maxPasses, p = 0;
   K   S = x.span();
   V   M = edgeWeight(x)/2;
-  vector<K> vcom(S), vcs, a(S);
-  vector<V> vtot(S), ctot(S), vcout(S);
-  float t = measureDurationMarked([&](auto mark) {
+  LouvainWorkspace<K, V> wl;
+  auto& wk = ws? *ws : wl;
+  louvainGrowWorkspace(wk, S);
+  auto& vcom = wk.vcom, &vcs = wk.vcs, &a = wk.a, &cmap = wk.cmap;
+  auto& vtot = wk.vtot, &ctot = wk.ctot, &vcout = wk.vcout;
+  vcs.clear();
+  fillValueU(vcout, V());
+  vector<float> tp; vector<int> lp; vector<K> np;
+  float ti = 0, tm = 0, tl = 0, ta = 0, tk = 0;
+  vector<PerfCounts> ci, cl, ca, ck;
+  PERFORMI(PerfCounters pc);
+  auto ft = [](auto u) { return true; };
+  auto fn = [](auto u) {};
+  G zf; int run = 0;
+  bool truncated = false;
+  size_t gb = 0, zb = 0;  // bytes of working graph, largest aggregated graph
+  ASSERT(!z || q);
+  auto ts = measureDurationsMarked([&](auto mark) {
+    // Discard phase timings of warm-up runs.
+    if (run++ == o.warmup) {
+      ti = tm = tl = ta = tk = 0;
+      tp.clear();
+      ci.clear(); cl.clear(); ca.clear(); ck.clear();
+    }
     V E  = o.tolerance;
     V Q0 = modularity(x, M, R);
     G y  = duplicate(x);
+    G w  = z? duplicate(*z) : G();
+    gb = y.bytes();
+    zb = z? w.bytes() : 0;
     fillValueU(vcom, K());
     fillValueU(vtot, V());
     fillValueU(ctot, V());
+    lp.clear(); np.clear();
     mark([&]() {
+      LouvainBudget bg(o.timeBudget, o.cancel, &o.progress);
+      auto t0 = timeNow();
+      PERFORMI(pc.start());
       louvainVertexWeights(vtot, y);
       if (q) louvainInitializeFrom(vcom, ctot, x, vtot, *q);
       else   louvainInitialize(vcom, ctot, y, vtot);
-      copyValues(vcom, a);
+      for (K u=0; u<S; ++u) a[u] = u;
+      PERFORMI(addPerfCountsAt(ci, 0, pc.stop()));
+      auto t1 = timeNow();
+      fm(vcom, vtot, ctot);
+      auto t2 = timeNow();
+      ti += durationMilliseconds(t0, t1);
+      tm += durationMilliseconds(t1, t2);
       for (l=0, p=0; M>0 && p<P;) {
         int m = 0;
-        if (p==0) m = louvainMove(vcom, ctot, vcs, vcout, y, vtot, M, R, E, L, fa, fp);
-        else      m = louvainMove(vcom, ctot, vcs, vcout, y, vtot, M, R, E, L);
+        auto t3 = timeNow();
+        PERFORMI(pc.start());
+        bg.setPass(p);
+        if (p==0 && aff) m = louvainMove(vcom, ctot, vcs, vcout, y, vtot, M, R, E, L, *aff, fp, &bg);
+        else if (p==0)   m = louvainMove(vcom, ctot, vcs, vcout, y, vtot, M, R, E, L, fa, fp, &bg);
+        else             m = louvainMove(vcom, ctot, vcs, vcout, y, vtot, M, R, E, L, ft, fn, &bg);
+        PERFORMI(addPerfCountsAt(cl, p, pc.stop()));
+        auto t4 = timeNow();
+        tl += durationMilliseconds(t3, t4);
+        if (tp.size()<=size_t(p)) tp.push_back(0);
+        lp.push_back(m);
+        np.push_back(y.order());
         l += m; ++p;
-        if (m<=1 || p>=P) { louvainLookupCommunities(a, vcom); break; }
+        PERFORMI(pc.start());
+        if (z && p==1) louvainAggregateMovesW(w, y, *q, vcom);
+        // Stop after a pass whose local-moving was stopped (by time budget or cancellation).
+        if (m<=1 || p>=P || bg.stopped()) {
+          if (!z || p>1) louvainRenumberCommunities(vcom, cmap, y);
+          PERFORMI(addPerfCountsAt(ca, p-1, pc.stop()));
+          auto t5 = timeNow();
+          PERFORMI(pc.start());
+          louvainLookupCommunities(a, vcom);
+          PERFORMI(addPerfCountsAt(ck, p-1, pc.stop()));
+          auto t6 = timeNow();
+          PERFORMI(pc.start());
+          if (z) zf = p==1? move(w) : louvainAggregate(vcs, vcout, y, vcom);
+          PERFORMI(addPerfCountsAt(ca, p-1, pc.stop()));
+          auto t7 = timeNow();
+          tk += durationMilliseconds(t5, t6);
+          ta += durationMilliseconds(t4, t5) + durationMilliseconds(t6, t7);
+          tp[p-1] += durationMilliseconds(t3, t7);
+          truncated |= bg.stopped();
+          if (z) zb = max(zb, zf.bytes());
+          break;
+        }
         // K N0 = y.order();
-        y = louvainAggregate(vcs, vcout, y, vcom);
+        // Incrementally maintained aggregate keeps community ids of q.
+        if (z && p==1) y = move(w);
+        else { louvainRenumberCommunities(vcom, cmap, y); y = louvainAggregate(vcs, vcout, y, vcom); }
+        zb = max(zb, y.bytes());
         // K N1 = y.order();
         // if (N1==N0) break;
+        PERFORMI(addPerfCountsAt(ca, p-1, pc.stop()));
+        auto t5 = timeNow();
+        PERFORMI(pc.start());
         louvainLookupCommunities(a, vcom);
+        PERFORMI(addPerfCountsAt(ck, p-1, pc.stop()));
+        auto t6 = timeNow();
+        ta += durationMilliseconds(t4, t5);
+        tk += durationMilliseconds(t5, t6);
         PRINTFD("louvainSeq(): p=%d, l=%d, m=%d, Q=%f\n", p, l, m, modularity(y, M, R));
         V Q = D? modularity(y, M, R) : V();
-        if (D && Q-Q0<=D) break;
-        fillValueU(vcom, K());
-        fillValueU(vtot, V());
-        fillValueU(ctot, V());
+        if (D && Q-Q0<=D) { if (z) zf = y; tp[p-1] += durationMilliseconds(t3, timeNow()); break; }
+        auto t7 = timeNow();
+        PERFORMI(pc.start());
+        fillValueU(vcom, 0, y.span(), K());
+        fillValueU(vtot, 0, y.span(), V());
+        fillValueU(ctot, 0, y.span(), V());
         louvainVertexWeights(vtot, y);
         louvainInitialize(vcom, ctot, y, vtot);
+        PERFORMI(addPerfCountsAt(ci, p, pc.stop()));
+        auto t8 = timeNow();
+        ti += durationMilliseconds(t7, t8);
+        tp[p-1] += durationMilliseconds(t3, t8);
         E /= o.tolerenceDeclineFactor;
         Q0 = Q;
       }
     });
-  }, o.repeat);
-  return LouvainResult<K>(a, l, p, t);
+  }, o.repeat, o.warmup);
+  louvainAbsentCommunitiesW(a, x);
+  if (z) *z = move(zf);
+  auto r = louvainResultFrom(x, a, l, p, ts, o, ti, tm, tl, ta, tk, tp, lp, np);
+  r.truncated  = truncated;
+  r.graphBytes     = gb;
+  r.aggregateBytes = zb;
+  r.workspaceBytes = louvainWorkspaceBytes(wk);
+  r.affectedBytes  = aff? aff->bytes() : 0;
+  for (auto& c : ci) c /= o.repeat;
+  for (auto& c : cl) c /= o.repeat;
+  for (auto& c : ca) c /= o.repeat;
+  for (auto& c : ck) c /= o.repeat;
+  r.passInitializationCounts = ci;
+  r.passLocalMoveCounts      = cl;
+  r.passAggregationCounts    = ca;
+  r.passLookupCounts         = ck;
+  return r;
+}
+template <class G, class K, class V, class FA, class FP>
+inline auto louvainSeq(const G& x, const vector<K>* q, const LouvainOptions<V>& o, FA fa, FP fp) {
+  auto fm = [](const auto& vcom, const auto& vtot, const auto& ctot) {};
+  return louvainSeq(x, q, o, fm, fa, fp);
 }
 template <class G, class K, class V, class FA>
 inline auto louvainSeq(const G& x, const vector<K>* q, const LouvainOptions<V>& o, FA fa) {
@@ -84,8 +202,11 @@ inline auto louvainSeq(const G& x, const vector<K>* q, const LouvainOptions<V>&
 // ------------------
 
 template <class G, class K, class V=float>
-inline auto louvainSeqStatic(const G& x, const vector<K>* q=nullptr, const LouvainOptions<V>& o={}) {
-  return louvainSeq(x, q, o);
+inline auto louvainSeqStatic(const G& x, const vector<K>* q=nullptr, const LouvainOptions<V>& o={}, LouvainWorkspace<K, V>* ws=nullptr) {
+  auto fm = [](const auto& vcom, const auto& vtot, const auto& ctot) {};
+  auto fa = [](auto u) { return true; };
+  auto fp = [](auto u) {};
+  return louvainSeq(x, q, o, fm, fa, fp, (G*) nullptr, ws);
 }
 
 
@@ -95,17 +216,18 @@ inline auto louvainSeqStatic(const G& x, const vector<K>* q=nullptr, const Louva
 // -----------------------------------
 
 template <class G, class K, class V>
-inline auto louvainSeqDynamicDeltaScreening(const G& x, const vector<tuple<K, K>>& deletions, const vector<tuple<K, K, V>>& insertions, const vector<K>* q, const LouvainOptions<V>& o={}) {
-  K S = x.span();
-  V R = o.resolution;
-  V M = edgeWeight(x)/2;
-  const vector<K>& vcom = *q;
-  vector<V> vtot(S), ctot(S);
-  louvainVertexWeights(vtot, x);
-  louvainCommunityWeights(ctot, x, vcom, vtot);
-  auto vaff = louvainAffectedVerticesDeltaScreening(x, deletions, insertions, vcom, vtot, ctot, M, R);
-  auto fa   = [&](auto u) { return vaff[u]==true; };
-  return louvainSeq(x, q, o, fa);
+inline auto louvainSeqDynamicDeltaScreening(const G& x, const EdgeBatch<K, V>& batch, const vector<K>* q, const LouvainOptions<V>& o={}, G* z=nullptr, LouvainWorkspace<K, V>* ws=nullptr) {
+  auto fl = [](auto&&... args) { return louvainSeq(args...); };
+  auto fw = [](auto& wk) { return tie(wk.vcs, wk.vcout); };
+  return louvainDynamicDeltaScreeningWith(fl, fw, x, batch, q, o, z, ws);
+}
+template <class G, class K, class V>
+inline auto louvainSeqDynamicDeltaScreening(const G& x, const vector<tuple<K, K, V>>& updates, const vector<K>* q, const LouvainOptions<V>& o={}, G* z=nullptr, LouvainWorkspace<K, V>* ws=nullptr) {
+  return louvainSeqDynamicDeltaScreening(x, edgeBatchOmp(updates, x.span()), q, o, z, ws);
+}
+template <class G, class K, class V>
+inline auto louvainSeqDynamicDeltaScreening(const G& x, const vector<tuple<K, K, V>>& deletions, const vector<tuple<K, K, V>>& insertions, const vector<K>* q, const LouvainOptions<V>& o={}, G* z=nullptr, LouvainWorkspace<K, V>* ws=nullptr) {
+  return louvainSeqDynamicDeltaScreening(x, edgeUpdates(deletions, insertions), q, o, z, ws);
 }
 
 
@@ -115,11 +237,60 @@ inline auto louvainSeqDynamicDeltaScreening(const G& x, const vector<tuple<K, K>
 // ----------------------------
 
 template <class G, class K, class V>
-inline auto louvainSeqDynamicFrontier(const G& x, const vector<tuple<K, K>>& deletions, const vector<tuple<K, K, V>>& insertions, const vector<K>* q, const LouvainOptions<V>& o={}) {
-  K S = x.span();
-  const vector<K>& vcom = *q;
-  auto vaff = louvainAffectedVerticesFrontier(x, deletions, insertions, vcom);
-  auto fa = [&](auto u) { return vaff[u]==true; };
-  auto fp = [&](auto u) { x.forEachEdgeKey(u, [&](auto v) { vaff[v] = true; }); };
-  return louvainSeq(x, q, o, fa, fp);
+inline auto louvainSeqDynamicFrontier(const G& x, const EdgeBatch<K, V>& batch, const vector<K>* q, const LouvainOptions<V>& o={}, G* z=nullptr, LouvainWorkspace<K, V>* ws=nullptr) {
+  auto fl = [](auto&&... args) { return louvainSeq(args...); };
+  return louvainDynamicFrontierWith(fl, x, batch, q, o, z, ws);
+}
+template <class G, class K, class V>
+inline auto louvainSeqDynamicFrontier(const G& x, const vector<tuple<K, K, V>>& updates, const vector<K>* q, const LouvainOptions<V>& o={}, G* z=nullptr, LouvainWorkspace<K, V>* ws=nullptr) {
+  return louvainSeqDynamicFrontier(x, edgeBatchOmp(updates, x.span()), q, o, z, ws);
+}
+template <class G, class K, class V>
+inline auto louvainSeqDynamicFrontier(const G& x, const vector<tuple<K, K, V>>& deletions, const vector<tuple<K, K, V>>& insertions, const vector<K>* q, const LouvainOptions<V>& o={}, G* z=nullptr, LouvainWorkspace<K, V>* ws=nullptr) {
+  return louvainSeqDynamicFrontier(x, edgeUpdates(deletions, insertions), q, o, z, ws);
+}
+
+
+
+
+// LOUVAIN-SEQ-DYNAMIC-DELTA-FRONTIER
+// ----------------------------------
+
+template <class G, class K, class V>
+inline auto louvainSeqDynamicDeltaFrontier(const G& x, const EdgeBatch<K, V>& batch, const vector<K>* q, const LouvainOptions<V>& o={}, G* z=nullptr, LouvainWorkspace<K, V>* ws=nullptr) {
+  auto fl = [](auto&&... args) { return louvainSeq(args...); };
+  auto fw = [](auto& wk) { return tie(wk.vcs, wk.vcout); };
+  return louvainDynamicDeltaFrontierWith(fl, fw, x, batch, q, o, z, ws);
+}
+template <class G, class K, class V>
+inline auto louvainSeqDynamicDeltaFrontier(const G& x, const vector<tuple<K, K, V>>& updates, const vector<K>* q, const LouvainOptions<V>& o={}, G* z=nullptr, LouvainWorkspace<K, V>* ws=nullptr) {
+  return louvainSeqDynamicDeltaFrontier(x, edgeBatchOmp(updates, x.span()), q, o, z, ws);
+}
+
+
+
+
+// LOUVAIN-SEQ-DYNAMIC-AUTO
+// ------------------------
+
+/**
+ * Find communities upon a batch update, with a technique chosen by its estimated affected fraction.
+ * @param x updated graph
+ * @param batch edge weight deltas for this batch update (undirected, grouped by source vertex)
+ * @param q initial community each vertex belongs to (before the update)
+ * @param o louvain options (with limits of each technique)
+ * @param z aggregated graph as per q, without the batch applied (updated to final communities)
+ * @param ws workspace to reuse across calls
+ * @returns result, with chosen technique and estimated affected fraction
+ */
+template <class G, class K, class V>
+inline auto louvainSeqDynamicAuto(const G& x, const EdgeBatch<K, V>& batch, const vector<K>* q, const LouvainOptions<V>& o={}, G* z=nullptr, LouvainWorkspace<K, V>* ws=nullptr) {
+  auto fl = [](auto&&... args) { return louvainSeq(args...); };
+  auto fw = [](auto& wk) { return tie(wk.vcs, wk.vcout); };
+  auto fz = [](const G& x, const vector<K>& vcom, LouvainWorkspace<K, V>*) { return louvainAggregate(x, vcom); };
+  return louvainDynamicAutoWith(fl, fw, fz, x, batch, q, o, z, ws);
+}
+template <class G, class K, class V>
+inline auto louvainSeqDynamicAuto(const G& x, const vector<tuple<K, K, V>>& updates, const vector<K>* q, const LouvainOptions<V>& o={}, G* z=nullptr, LouvainWorkspace<K, V>* ws=nullptr) {
+  return louvainSeqDynamicAuto(x, edgeBatchOmp(updates, x.span()), q, o, z, ws);
 }
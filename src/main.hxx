@@ -15,5 +15,10 @@
 #include "properties.hxx"
 #include "modularity.hxx"
 #include "random.hxx"
+#include "update.hxx"
 #include "louvain.hxx"
 #include "louvainSeq.hxx"
+#include "louvainOmp.hxx"
+#include "louvainScheduler.hxx"
+#include "louvainPipeline.hxx"
+#include "louvainMany.hxx"
@@ -1,4 +1,7 @@
 #pragma once
+#include <cstdlib>
+#include <tuple>
+#include <vector>
 #include <string>
 #include <istream>
 #include <sstream>
@@ -6,7 +9,10 @@
 #include <algorithm>
 #include "_main.hxx"
 #include "Graph.hxx"
+#include "csr.hxx"
 
+using std::tuple;
+using std::vector;
 using std::string;
 using std::istream;
 using std::stringstream;
@@ -14,6 +20,8 @@ using std::ifstream;
 using std::ofstream;
 using std::getline;
 using std::max;
+using std::strtoull;
+using std::strtod;
 
 
 
@@ -80,6 +88,76 @@ void readMtxW(G& a, const char *pth, bool unq=false) {
 }
 
 
+/**
+ * Read a graph from an MTX file, with edge lines parsed in parallel.
+ * The file is split into one block of lines per thread, and the parsed edges
+ * are built into rows in parallel (with duplicate edges merged).
+ * @param a output graph (updated, should be empty)
+ * @param pth path of MTX file
+ */
+template <class G>
+void readMtxOmpW(G& a, const char *pth) {
+  using K = typename G::key_type;
+  using E = typename G::edge_value_type;
+  string buf = readFileText(pth), ln, h0, h1, h2, h3, h4;
+  size_t B = buf.size(), p = 0;
+
+  // read header
+  while (p<B) {
+    size_t e = buf.find('\n', p);
+    if (e==string::npos) e = B;
+    ln = buf.substr(p, e-p); p = e+1;
+    if (ln.find('%')!=0) break;
+    if (ln.find("%%")!=0) continue;
+    stringstream ls(ln);
+    ls >> h0 >> h1 >> h2 >> h3 >> h4;
+  }
+  if (h1!="matrix" || h2!="coordinate") return;
+  bool sym = h4=="symmetric" || h4=="skew-symmetric";
+
+  // read rows, cols, size
+  size_t r, c, sz;
+  stringstream ls(ln);
+  ls >> r >> c >> sz;
+  size_t n = max(r, c);
+  for (size_t u=1; u<=n; u++)
+    a.addVertex(K(u));
+
+  // read edges (from, to), each thread from the lines that start in its block
+  int P = ompMaxThreads();
+  vector<vector<tuple<K, K, E>>> esp(P);
+  const char *s = buf.c_str();
+  if (p>B) p = B;
+  #pragma omp parallel for schedule(static, 1)
+  for (int t=0; t<P; ++t) {
+    size_t i = p + (B-p)*t/P, ie = p + (B-p)*(t+1)/P;
+    while (i<ie && i>p && s[i-1]!='\n') ++i;
+    while (i<ie) {
+      size_t e = buf.find('\n', i);
+      if (e==string::npos) e = B;
+      char *q0, *q1, *q2;
+      size_t u = strtoull(s+i, &q0, 10);
+      size_t v = strtoull(q0, &q1, 10);
+      if (q0==s+i || q1==q0 || q1>s+e) { i = e+1; continue; }
+      double w = strtod(q1, &q2);
+      if (q2==q1 || q2>s+e) w = 1;
+      esp[t].push_back({K(u), K(v), E(w)});
+      i = e+1;
+    }
+  }
+  vector<size_t> offsets(P+1);
+  for (int t=0; t<P; ++t)
+    offsets[t+1] = offsets[t] + esp[t].size();
+  vector<tuple<K, K, E>> es(offsets[P]);
+  #pragma omp parallel for schedule(static, 1)
+  for (int t=0; t<P; ++t)
+    copy(esp[t].begin(), esp[t].end(), es.begin() + offsets[t]);
+  vector<K> xv, xe; vector<E> xw;
+  csrFromEdgesOmpW(xv, xe, xw, es, K(n+1), sym);
+  csrAddEdgesOmpW(a, xv.data(), (const K*) nullptr, xe.data(), xw.data(), n+1);
+}
+
+
 #define READ_MTX_RETURN(R, unq) \
   inline auto readMtx##R(istream& s) { \
     R<> a; readMtxW(a, s, unq); \
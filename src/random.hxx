@@ -1,6 +1,80 @@
+#pragma once
 #include <random>
+#include <vector>
+#include <algorithm>
 
+using std::vector;
 using std::uniform_real_distribution;
+using std::uniform_int_distribution;
+using std::upper_bound;
+
+
+
+
+// DEGREE-PREFIX-SUM
+// -----------------
+// Cumulative degree of vertices, for sampling them by degree in O(log V).
+
+/**
+ * Find cumulative degree of given vertices.
+ * @param x original graph
+ * @param ks vertices to consider (in order)
+ * @returns offsets, where vertex ks[i] covers [offsets[i], offsets[i+1])
+ */
+template <class G, class J>
+auto degreePrefixSum(const G& x, const J& ks) {
+  vector<size_t> a(1);
+  for (auto u : ks)
+    a.push_back(a.back() + x.degree(u));
+  return a;
+}
+
+
+/**
+ * Pick a random index in [i, I), with probability proportional to its degree.
+ * @param rnd random number generator
+ * @param offsets cumulative degree of vertices
+ * @param i begin index
+ * @param I end index
+ * @returns sampled index, or I if all degrees are zero
+ */
+template <class R>
+size_t randomIndexByPrefixSum(R& rnd, const vector<size_t>& offsets, size_t i, size_t I) {
+  if (offsets[I] <= offsets[i]) return I;
+  uniform_int_distribution<size_t> dis(offsets[i], offsets[I]-1);
+  auto it = upper_bound(offsets.begin()+i, offsets.begin()+I+1, dis(rnd));
+  return size_t(it - offsets.begin()) - 1;
+}
+
+template <class R>
+inline size_t randomIndexByPrefixSum(R& rnd, const vector<size_t>& offsets) {
+  return randomIndexByPrefixSum(rnd, offsets, 0, offsets.size()-1);
+}
+
+
+
+
+// VERTEX-KEYS-BY-GROUP
+// --------------------
+
+/**
+ * Obtain vertices ordered by group (counting sort).
+ * @param ks vertices ordered by group (output)
+ * @param goff offset of each group in ks (output)
+ * @param x original graph
+ * @param vgrp group each vertex belongs to
+ */
+template <class G, class K>
+void vertexKeysByGroup(vector<K>& ks, vector<size_t>& goff, const G& x, const vector<K>& vgrp) {
+  K S = x.span();
+  ks.resize(x.order());
+  goff.assign(S+1, 0);
+  x.forEachVertexKey([&](auto u) { ++goff[vgrp[u]+1]; });
+  for (K c=0; c<S; ++c)
+    goff[c+1] += goff[c];
+  vector<size_t> gi(goff.begin(), goff.end()-1);
+  x.forEachVertexKey([&](auto u) { ks[gi[vgrp[u]]++] = u; });
+}
 
 
 
@@ -27,18 +101,19 @@ bool addRandomEdge(G& a, R& rnd, K span, V w) {
 template <class G, class R, class K, class V, class FE>
 bool addRandomEdgeByDegree(const G& x, R& rnd, K span, V w, FE fe) {
   uniform_real_distribution<> dis(0.0, 1.0);
-  double deg = x.size() / x.span();
-  K un = K(dis(rnd) * deg * span);
-  K vn = K(dis(rnd) * deg * span);
-  K u = K(), v = K(), n = K();
+  double deg = double(x.size()) / span;
+  double un  = dis(rnd) * deg * span;
+  double vn  = dis(rnd) * deg * span;
+  double n   = 0;
+  K u = K(), v = K();
+  bool uf = false, vf = false;
   x.forEachVertexKey([&](auto t) {
-    if (un<0 && un > n+x.degree(t)) u = t;
-    if (vn<0 && vn > n+x.degree(t)) v = t;
-    if (un>0 && vn>=0) return;
+    if (uf && vf) return;
     n += x.degree(t);
+    if (!uf && un < n) { u = t; uf = true; }
+    if (!vf && vn < n) { v = t; vf = true; }
   });
-  if (!u) u = K(un/deg);
-  if (!v) v = K(vn/deg);
+  if (!uf || !vf) return false;
   fe(u, v, w);
   return true;
 }
@@ -50,6 +125,52 @@ bool addRandomEdgeByDegree(G& a, R& rnd, K span, V w) {
 }
 
 
+/**
+ * Add a random edge, with endpoints chosen by degree (preferential attachment).
+ * @param x original graph
+ * @param rnd random number generator
+ * @param ks vertices to choose from
+ * @param offsets cumulative degree of ks
+ * @param w edge weight
+ * @param fe edge add function (u, v, w)
+ * @returns whether an edge was sampled
+ */
+template <class G, class R, class K, class V, class FE>
+bool addRandomEdgeByDegree(const G& x, R& rnd, const vector<K>& ks, const vector<size_t>& offsets, V w, FE fe) {
+  size_t N = ks.size();
+  size_t i = randomIndexByPrefixSum(rnd, offsets, 0, N);
+  size_t j = randomIndexByPrefixSum(rnd, offsets, 0, N);
+  if (i>=N || j>=N) return false;
+  fe(ks[i], ks[j], w);
+  return true;
+}
+
+
+/**
+ * Add a random edge within a group, with endpoints chosen by degree.
+ * @param x original graph
+ * @param rnd random number generator
+ * @param ks vertices ordered by group
+ * @param offsets cumulative degree of ks
+ * @param goff offset of each group in ks
+ * @param vgrp group each vertex belongs to
+ * @param w edge weight
+ * @param fe edge add function (u, v, w)
+ * @returns whether an edge was sampled
+ */
+template <class G, class R, class K, class V, class FE>
+bool addRandomEdgeWithinGroup(const G& x, R& rnd, const vector<K>& ks, const vector<size_t>& offsets, const vector<size_t>& goff, const vector<K>& vgrp, V w, FE fe) {
+  size_t N = ks.size();
+  size_t i = randomIndexByPrefixSum(rnd, offsets, 0, N);
+  if (i>=N) return false;
+  K u = ks[i], c = vgrp[u];
+  size_t j = randomIndexByPrefixSum(rnd, offsets, goff[c], goff[c+1]);
+  if (j>=goff[c+1]) return false;
+  fe(u, ks[j], w);
+  return true;
+}
+
+
 
 
 // REMOVE-RANDOM-EDGE
@@ -94,12 +215,12 @@ template <class G, class R, class FE>
 bool removeRandomEdgeByDegree(const G& x, R& rnd, FE fe) {
   using K = typename G::key_type;
   uniform_real_distribution<> dis(0.0, 1.0);
-  K v = K(dis(rnd) * x.size()), n = 0;
+  double v = dis(rnd) * x.size(), n = 0;
   bool attempted = false, removed = false;
   x.forEachVertexKey([&](auto u) {
     if (attempted) return;
-    if (v > n+x.degree(u)) n += x.degree(u);
-    else { removed = removeRandomEdge(x, rnd, u, fe); attempted = true; }
+    n += x.degree(u);
+    if (v < n) { removed = removeRandomEdgeFrom(x, rnd, K(u), fe); attempted = true; }
   });
   return removed;
 }
@@ -109,3 +230,21 @@ bool removeRandomEdgeByDegree(G& a, R& rnd) {
   auto fe = [&](auto u, auto v) { a.removeEdge(u, v); };
   return removeRandomEdgeByDegree(a, rnd, fe);
 }
+
+
+/**
+ * Remove a random edge, with source chosen by degree (uniform over edges).
+ * @param x original graph
+ * @param rnd random number generator
+ * @param ks vertices to choose from
+ * @param offsets cumulative degree of ks (may be stale)
+ * @param fe edge remove function (u, v)
+ * @returns whether an edge was sampled
+ */
+template <class G, class R, class K, class FE>
+bool removeRandomEdgeByDegree(const G& x, R& rnd, const vector<K>& ks, const vector<size_t>& offsets, FE fe) {
+  size_t N = ks.size();
+  size_t i = randomIndexByPrefixSum(rnd, offsets, 0, N);
+  if (i>=N) return false;
+  return removeRandomEdgeFrom(x, rnd, ks[i], fe);
+}
@@ -1,4 +1,11 @@
 #pragma once
+#include <tuple>
+#include <vector>
+#include "_main.hxx"
+#include "csr.hxx"
+
+using std::tuple;
+using std::vector;
 
 
 
@@ -23,3 +30,38 @@ auto symmetricize(const G& x) {
   G a; symmetricizeW(a, x);
   return a;
 }
+
+
+/**
+ * Symmetricize a graph, with its edges built into rows in parallel.
+ * @param a output graph (updated, should be empty)
+ * @param x original graph
+ */
+template <class H, class G>
+void symmetricizeOmpW(H& a, const G& x) {
+  using K = typename G::key_type;
+  using E = typename G::edge_value_type;
+  K S = x.span();
+  vector<size_t> offsets(S+1);
+  #pragma omp parallel for schedule(auto)
+  for (K u=0; u<S; ++u)
+    offsets[u] = x.hasVertex(u)? x.degree(u) : 0;
+  offsets[S] = 0;
+  exclusiveScanOmp(offsets, offsets);
+  vector<tuple<K, K, E>> es(offsets[S]);
+  #pragma omp parallel for schedule(dynamic, 2048)
+  for (K u=0; u<S; ++u) {
+    size_t i = offsets[u];
+    x.forEachEdge(u, [&](auto v, auto w) { es[i++] = {u, v, w}; });
+  }
+  vector<K> xv, xe; vector<E> xw;
+  csrFromEdgesOmpW(xv, xe, xw, es, S, true);
+  x.forEachVertex([&](auto u, auto d) { a.addVertex(u, d); });
+  csrAddEdgesOmpW(a, xv.data(), (const K*) nullptr, xe.data(), xw.data(), size_t(S));
+}
+
+template <class G>
+auto symmetricizeOmp(const G& x) {
+  G a; symmetricizeOmpW(a, x);
+  return a;
+}
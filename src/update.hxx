@@ -0,0 +1,180 @@
+#pragma once
+#include <tuple>
+#include <vector>
+#include <algorithm>
+#include "_main.hxx"
+#include "duplicate.hxx"
+
+using std::tuple;
+using std::vector;
+using std::get;
+using std::stable_sort;
+using std::lower_bound;
+
+
+
+
+// EDGE-UPDATES
+// ------------
+// A batch update is a list of (source, target, weight delta) records.
+// Positive deltas insert an edge or increase its weight, and negative
+// deltas decrease its weight, deleting it once the weight drops to zero.
+// A decrease should not exceed the current weight of the edge.
+
+/**
+ * Combine edge deletions, insertions, and weight changes into a batch of weight deltas.
+ * @param deletions edge deletions (with deleted weight)
+ * @param insertions edge insertions
+ * @param changes edge weight changes (as deltas)
+ * @returns edge weight deltas, sorted by source vertex id
+ */
+template <class K, class V>
+auto edgeUpdates(const vector<tuple<K, K, V>>& deletions, const vector<tuple<K, K, V>>& insertions, const vector<tuple<K, K, V>>& changes={}) {
+  vector<tuple<K, K, V>> a;
+  a.reserve(deletions.size() + insertions.size() + changes.size());
+  for (const auto& [u, v, w] : deletions)
+    a.push_back({u, v, -w});
+  for (const auto& [u, v, w] : insertions)
+    a.push_back({u, v,  w});
+  for (const auto& [u, v, w] : changes)
+    a.push_back({u, v,  w});
+  auto fl = [](const auto& p, const auto& q) { return get<0>(p) < get<0>(q); };
+  stable_sort(a.begin(), a.end(), fl);
+  return a;
+}
+
+
+
+
+// EDGE-BATCH
+// ----------
+// A batch update prepared for consumers that process it by source vertex.
+// Records are sorted by source and target vertex, deltas of the same edge are
+// merged (and dropped if they cancel out), and the records of each source
+// vertex are found directly with offsets. Sorting is a parallel radix sort on
+// the (source, target) key.
+
+template <class K, class V>
+struct EdgeBatch {
+  vector<tuple<K, K, V>> edges;  // edge weight deltas, sorted, one per edge
+  vector<K> sources;             // distinct source vertices, in order
+  vector<size_t> offsets;        // start of records of each source (last is number of records)
+};
+
+
+/**
+ * Prepare a batch of edge weight deltas for processing by source vertex.
+ * @param updates edge weight deltas (in any order, possibly with repeated edges)
+ * @param S span of vertex ids (all ids are less than this)
+ * @param symmetric add reverse records of edges given in one direction only?
+ * @returns sorted batch with per-source offsets
+ */
+template <class K, class V>
+EdgeBatch<K, V> edgeBatchOmp(const vector<tuple<K, K, V>>& updates, K S, bool symmetric=false) {
+  using E = tuple<K, K, V>;
+  EdgeBatch<K, V> a;
+  vector<E> es = updates, buf;
+  vector<size_t> is;
+  int b = 0;
+  while ((size_t(1) << b) < size_t(S)) ++b;
+  auto fk = [&](const E& e) { return size_t(get<0>(e)) * size_t(S) + size_t(get<1>(e)); };
+  radixSortOmpU(es, buf, fk, 2*b);
+  // Merge deltas of the same edge.
+  size_t N = es.size();
+  filterIndicesOmpW(is, N, [&](size_t i) { return i==0 || fk(es[i])!=fk(es[i-1]); });
+  size_t C = is.size(); is.push_back(N);
+  buf.resize(C);
+  #pragma omp parallel for schedule(auto)
+  for (size_t i=0; i<C; ++i) {
+    V w = V();
+    for (size_t j=is[i]; j<is[i+1]; ++j)
+      w += get<2>(es[j]);
+    buf[i] = {get<0>(es[is[i]]), get<1>(es[is[i]]), w};
+  }
+  filterIndicesOmpW(is, C, [&](size_t i) { return get<2>(buf[i])!=V(); });
+  a.edges.resize(is.size());
+  #pragma omp parallel for schedule(auto)
+  for (size_t i=0; i<is.size(); ++i)
+    a.edges[i] = buf[is[i]];
+  // Mirror edges whose reverse is missing, and prepare again.
+  if (symmetric) {
+    const auto& xs = a.edges;
+    auto fl = [&](const E& e, size_t k) { return fk(e) < k; };
+    filterIndicesOmpW(is, xs.size(), [&](size_t i) {
+      auto [u, v, w] = xs[i];
+      size_t k = size_t(v) * size_t(S) + size_t(u);
+      auto it  = lower_bound(xs.begin(), xs.end(), k, fl);
+      return it==xs.end() || fk(*it)!=k;
+    });
+    if (!is.empty()) {
+      es = xs;
+      for (size_t i : is)
+        es.push_back({get<1>(xs[i]), get<0>(xs[i]), get<2>(xs[i])});
+      return edgeBatchOmp(es, S, false);
+    }
+  }
+  // Find records of each source.
+  const auto& xs = a.edges;
+  filterIndicesOmpW(a.offsets, xs.size(), [&](size_t i) { return i==0 || get<0>(xs[i])!=get<0>(xs[i-1]); });
+  a.sources.resize(a.offsets.size());
+  #pragma omp parallel for schedule(auto)
+  for (size_t i=0; i<a.offsets.size(); ++i)
+    a.sources[i] = get<0>(xs[a.offsets[i]]);
+  a.offsets.push_back(xs.size());
+  return a;
+}
+
+
+
+
+// UPDATE-EDGE-WEIGHTS
+// -------------------
+
+template <class G, class K, class V>
+void updateEdgeWeightsU(G& a, const vector<tuple<K, K, V>>& updates) {
+  for (const auto& [u, v, w] : updates) {
+    V e = a.edgeValue(u, v) + w;
+    if (e<=V()) a.removeEdge(u, v);
+    else if (!a.setEdgeValue(u, v, e)) a.addEdge(u, v, e);
+  }
+  a.correct();
+}
+template <class G, class K, class V>
+auto updateEdgeWeights(const G& x, const vector<tuple<K, K, V>>& updates) {
+  auto a = duplicate(x); updateEdgeWeightsU(a, updates);
+  return a;
+}
+
+
+/**
+ * Apply a batch of edge weight deltas, with source vertices processed in parallel.
+ * @param a graph to update (updated)
+ * @param batch prepared batch of edge weight deltas
+ */
+template <class G, class K, class V>
+void updateEdgeWeightsOmpU(G& a, const EdgeBatch<K, V>& batch) {
+  const auto& es = batch.edges;
+  size_t N = batch.sources.size();
+  // Endpoints of added edges, not yet in the graph, are added first (addEdgeOmp() cannot).
+  for (const auto& [u, v, w] : es) {
+    if (w<=V()) continue;
+    if (!a.hasVertex(u)) a.addVertex(u);
+    if (!a.hasVertex(v)) a.addVertex(v);
+  }
+  // Only the thread processing a source vertex touches its out-edges.
+  #pragma omp parallel for schedule(dynamic, 64)
+  for (size_t i=0; i<N; ++i) {
+    for (size_t j=batch.offsets[i]; j<batch.offsets[i+1]; ++j) {
+      auto [u, v, w] = es[j];
+      V e = a.edgeValue(u, v) + w;
+      if (e<=V()) a.removeEdgeOmp(u, v);
+      else if (!a.setEdgeValue(u, v, e)) a.addEdgeOmp(u, v, e);
+    }
+  }
+  a.correct();
+}
+template <class G, class K, class V>
+auto updateEdgeWeightsOmp(const G& x, const EdgeBatch<K, V>& batch) {
+  auto a = duplicate(x); updateEdgeWeightsOmpU(a, batch);
+  return a;
+}